@@ -0,0 +1,95 @@
+import subprocess
+import argparse
+import os
+import resource
+import tempfile
+import time
+
+def stars_in_comment(size):
+    # Long runs of '*' that never close the comment bounce between states 3 and 4.
+    chunk = "*" * 1023 + "x"
+    return "(*" + chunk * (size // len(chunk)) + "*)\n"
+
+def line_comments(size):
+    # Every line comment used to recurse into getToken() twice.
+    return "\"\n" * (size // 2)
+
+def huge_line(size):
+    return "a := b + 1; " * (size // 12)
+
+def blanks(size):
+    return " " * size + "x\n"
+
+def nested_openers(size):
+    return "(" * size + "\n"
+
+# Generated inputs, as (name, generator).
+CASES = [
+    ("stars-in-comment", stars_in_comment),
+    ("line-comments", line_comments),
+    ("huge-line", huge_line),
+    ("blanks", blanks),
+    ("nested-openers", nested_openers),
+]
+
+def main():
+    parser = argparse.ArgumentParser(description="Run adversarial scanner inputs against latency and stack limits")
+
+    parser.add_argument("-p", "--program", type=str, required=True, metavar="EXECUTABLE", help="Scanner executable")
+    parser.add_argument("-m", "--megabytes", type=int, default=8, metavar="MB", help="Size of each generated input")
+    parser.add_argument("-t", "--max-seconds", type=float, default=5.0, metavar="SECONDS", help="Fail if a case takes longer")
+    parser.add_argument("-s", "--stack-kb", type=int, default=256, metavar="KB", help="Stack limit the scanner must run within")
+    parser.add_argument("-b", "--budget-ms", type=int, default=50, metavar="MS", help="Time budget checked on the largest case")
+
+    args = parser.parse_args()
+
+    failed = 0
+    with tempfile.TemporaryDirectory() as work_dir:
+        for (name, generate) in CASES:
+            path = os.path.join(work_dir, f"{name}.kpl")
+            with open(path, "w") as f:
+                f.write(generate(args.megabytes * 1024 * 1024))
+
+            (elapsed, returncode) = run_case(args.program, [path], args.stack_kb)
+            crashed = returncode < 0
+            ok = not crashed and elapsed <= args.max_seconds
+            failed += not ok
+
+            depth = f"{stack_needed(args.program, [path], args.stack_kb):5d}" if not crashed else "    -"
+            status = "ok" if ok else ("CRASHED" if crashed else "TOO SLOW")
+            print(f"{name:<18} {elapsed:8.3f}s  stack {depth} of {args.stack_kb} KB  {status}")
+
+        # One file over its time budget must not hold up the rest of the batch.
+        path = os.path.join(work_dir, "huge-line.kpl")
+        (elapsed, returncode) = run_case(args.program, ["-max-time", str(args.budget_ms), path, path], args.stack_kb)
+        ok = returncode >= 0 and elapsed <= 2 * (2 * args.budget_ms / 1000.0) + 0.5
+        failed += not ok
+        print(f"{'time-budget':<18} {elapsed:8.3f}s  budget {args.budget_ms} ms x2  {'ok' if ok else 'FAILED'}")
+
+    exit(1 if failed else 0)
+
+
+def run_case(program_path, arguments, stack_kb):
+    def limit_stack():
+        limit = stack_kb * 1024
+        resource.setrlimit(resource.RLIMIT_STACK, (limit, limit))
+
+    start = time.perf_counter()
+    process = subprocess.run([program_path] + arguments, stdout=subprocess.DEVNULL, preexec_fn=limit_stack)
+    return (time.perf_counter() - start, process.returncode)
+
+
+def stack_needed(program_path, arguments, stack_kb, step_kb=4):
+    # Smallest stack limit the case still runs within, found by bisecting
+    # RLIMIT_STACK down from stack_kb, which is known to be enough. This is the
+    # deepest the stack gets, plus what the kernel puts there at exec.
+    (low, high) = (0, stack_kb)
+    while high - low > step_kb:
+        middle = (low + high) // 2
+        if run_case(program_path, arguments, middle)[1] < 0:
+            low = middle
+        else:
+            high = middle
+    return high
+
+main()
@@ -0,0 +1,209 @@
+import subprocess
+import argparse
+import json
+import os
+import sys
+import tempfile
+import time
+
+# Scanner invocations compared by the benchmark, as (name, extra arguments).
+# Whether -pipeline beats sequential scanning is unmeasured: it has only been
+# timed on one core, where its three threads take turns instead of overlapping.
+MODES = [
+    ("sequential", []),
+    ("pipeline", ["-pipeline"]),
+]
+
+# Token filters compared on the single file, against printing every token.
+FILTER_MODES = [
+    ("all tokens", []),
+    ("identifiers", ["-only", "TK_IDENT"]),
+    ("keywords", ["-only", "KW_"]),
+    ("no symbols", ["-only", "TK_,KW_"]),
+    ("symbols", ["-only", "SB_"]),
+    ("count", ["-count"]),
+    ("stats", ["-stats"]),
+]
+
+# Compiled lexer variants, counting only so that output does not hide them.
+VARIANT_MODES = [
+    ("default", ["-count"]),
+    ("exact keywords", ["-count", "-exact-keywords"]),
+    ("no positions", ["-count", "-no-positions"]),
+    ("bare", ["-count", "-no-positions", "-exact-keywords"]),
+]
+
+# Modes compared on a corpus of many small files.
+CORPUS_MODES = [
+    ("sequential", []),
+    ("preload", ["-preload"]),
+    ("preload-pread", ["-preload-pread"]),
+]
+
+# The same corpus packed with kplpack, scanned on this many threads.
+ARCHIVE_MODES = [
+    ("archive", 1),
+    ("archive -j4", 4),
+]
+
+# Allowed growth of peak memory per input MB over the baseline, in percent.
+MEMORY_TOLERANCE = 5
+
+def main():
+    parser = argparse.ArgumentParser(description="Benchmark scanner modes")
+
+    parser.add_argument("-p", "--program", type=str, required=True, metavar="EXECUTABLE", help="Scanner executable")
+    parser.add_argument("-s", "--source", type=str, default=os.path.join(os.path.dirname(__file__), "..", "test", "kpl_max.kpl"), metavar="SOURCE", help="KPL file repeated to build the input")
+    parser.add_argument("-m", "--megabytes", type=int, default=64, metavar="MB", help="Size of the generated input")
+    parser.add_argument("-c", "--corpus", type=int, default=0, metavar="FILES", help="Also benchmark a corpus of this many small files")
+    parser.add_argument("-f", "--filters", action="store_true", help="Also benchmark token filters and counting")
+    parser.add_argument("-v", "--variants", action="store_true", help="Also benchmark the specialized lexer variants")
+    parser.add_argument("-r", "--repeat", type=int, default=3, metavar="N", help="Runs per mode, best time is reported")
+    parser.add_argument("-b", "--memory-baseline", type=str, metavar="JSON", help="Fail if peak memory per input MB of any mode exceeds this baseline")
+    parser.add_argument("-u", "--update-baseline", action="store_true", help="Write the measured memory to the baseline instead")
+
+    args = parser.parse_args()
+
+    memory = {}
+    with tempfile.TemporaryDirectory() as work_dir:
+        input_file = make_input(work_dir, args.source, args.megabytes)
+        print(f"Single {args.megabytes} MB file:")
+        if (os.cpu_count() or 1) < 3:
+            print(f"  note: {os.cpu_count()} CPU(s); the pipeline's three stages cannot all run at once")
+        run_modes(args.program, MODES, [input_file], args.megabytes, args.repeat)
+        if args.memory_baseline:
+            measure_modes(args.program, f"single {args.megabytes} MB", MODES, [input_file], args.megabytes, memory)
+
+        if args.filters:
+            print(f"Filters on the {args.megabytes} MB file:")
+            run_modes(args.program, FILTER_MODES, [input_file], args.megabytes, args.repeat)
+
+        if args.variants:
+            print(f"Lexer variants on the {args.megabytes} MB file:")
+            run_modes(args.program, VARIANT_MODES, [input_file], args.megabytes, args.repeat)
+
+        if args.corpus > 0:
+            corpus = make_corpus(work_dir, args.corpus)
+            megabytes = sum(os.path.getsize(f) for f in corpus) / (1024 * 1024)
+            archive = pack_corpus(args.program, work_dir, corpus)
+            modes = CORPUS_MODES + [(name, ["-archive", archive, "-j", str(threads)]) for (name, threads) in ARCHIVE_MODES]
+            print(f"Corpus of {args.corpus} files:")
+            run_modes(args.program, modes, corpus, megabytes, args.repeat)
+            if args.memory_baseline:
+                measure_modes(args.program, f"corpus of {args.corpus}", modes, corpus, megabytes, memory)
+
+    if args.memory_baseline:
+        if args.update_baseline:
+            save_baseline(args.memory_baseline, memory)
+        elif not check_memory(args.memory_baseline, memory):
+            sys.exit(1)
+
+
+def run_modes(program_path, modes, input_files, megabytes, repeat):
+    baseline = None
+    for (name, extra_args) in modes:
+        elapsed = run_mode(program_path, extra_args, input_files, repeat)
+        if baseline is None:
+            baseline = elapsed
+        print(f"  {name:<14} {elapsed:8.3f}s  {megabytes / elapsed:8.1f} MB/s  x{baseline / elapsed:.2f}")
+
+
+def measure_modes(program_path, group, modes, input_files, megabytes, memory):
+    """Record the accounted peak bytes per input MB of each mode, as -memstats reports them."""
+    print(f"Peak memory, {group}:")
+    for (name, extra_args) in modes:
+        peak = run_memstats(program_path, extra_args, input_files)
+        memory[f"{group}: {name}"] = round(peak / megabytes)
+        print(f"  {name:<14} {peak / 1024:10.0f} KB  {peak / megabytes / 1024:8.1f} KB/MB")
+
+
+def run_memstats(program_path, extra_args, input_files):
+    if "-archive" in extra_args:
+        input_files = []
+    result = subprocess.run([program_path, "-memstats"] + extra_args + input_files, stdout=subprocess.DEVNULL, stderr=subprocess.PIPE, text=True, check=True)
+    for line in result.stderr.splitlines():
+        fields = line.split()
+        if fields and fields[0] == "total":
+            return int(fields[2])
+    raise RuntimeError("no memory report from " + program_path)
+
+
+def save_baseline(path, memory):
+    with open(path, "w") as f:
+        json.dump(memory, f, indent=2, sort_keys=True)
+        f.write("\n")
+    print(f"Memory baseline written to {path}")
+
+
+def check_memory(path, memory):
+    """Compare against the baseline; inputs it has no entry for are only reported."""
+    with open(path) as f:
+        baseline = json.load(f)
+
+    passed = True
+    for key, per_mb in memory.items():
+        if key not in baseline:
+            print(f"  no baseline: {key}")
+        elif per_mb > baseline[key] * (1 + MEMORY_TOLERANCE / 100):
+            print(f"  REGRESSION: {key}: {per_mb / 1024:.1f} KB/MB, baseline {baseline[key] / 1024:.1f} KB/MB")
+            passed = False
+    print("Memory within baseline" if passed else "Memory per input MB went up")
+    return passed
+
+
+def make_input(work_dir, source, megabytes):
+    with open(source) as f:
+        chunk = f.read()
+
+    path = os.path.join(work_dir, "input.kpl")
+    with open(path, "w") as f:
+        for _ in range(megabytes * 1024 * 1024 // len(chunk)):
+            f.write(chunk)
+
+    return path
+
+
+def make_corpus(work_dir, count):
+    test_dir = os.path.join(os.path.dirname(__file__), "..", "test")
+    sources = []
+    for name in ["example1.kpl", "example2.kpl", "example3.kpl"]:
+        with open(os.path.join(test_dir, name)) as f:
+            sources.append(f.read())
+
+    corpus_dir = os.path.join(work_dir, "corpus")
+    os.mkdir(corpus_dir)
+
+    paths = []
+    for i in range(count):
+        path = os.path.join(corpus_dir, f"{i}.kpl")
+        with open(path, "w") as f:
+            f.write(sources[i % len(sources)])
+        paths.append(path)
+
+    return paths
+
+
+def pack_corpus(program_path, work_dir, corpus):
+    packer = os.path.join(os.path.dirname(os.path.abspath(program_path)), "kplpack")
+    list_path = os.path.join(work_dir, "corpus.txt")
+    with open(list_path, "w") as f:
+        f.write("\n".join(corpus) + "\n")
+
+    path = os.path.join(work_dir, "corpus.pak")
+    subprocess.run([packer, path, "-l", list_path], stdout=subprocess.DEVNULL, check=True)
+    return path
+
+
+def run_mode(program_path, extra_args, input_files, repeat):
+    # An archive holds the inputs itself.
+    if "-archive" in extra_args:
+        input_files = []
+    best = None
+    for _ in range(repeat):
+        start = time.perf_counter()
+        subprocess.run([program_path] + extra_args + input_files, stdout=subprocess.DEVNULL, check=True)
+        elapsed = time.perf_counter() - start
+        best = elapsed if best is None else min(best, elapsed)
+    return best
+
+main()
@@ -0,0 +1,155 @@
+/* Compares the C++ token range and generator against the raw C loops.
+ *
+ * Usage: rangebench [-r N] FILE
+ *
+ * The file is scanned from memory so that only lexing and the iteration
+ * layer are timed. Each loop folds every token into a checksum, which must
+ * agree across loops; the best of N rounds is reported per loop.
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+
+#include "scanner.hpp"
+
+typedef unsigned long long (*Loop)(const std::string &data, long long *count);
+
+static inline unsigned long long fold(unsigned long long sum, const Token &token)
+{
+    return sum * 31 + (unsigned)token.tokenType * 7 + (unsigned)token.offset + (unsigned)token.value;
+}
+
+// Legacy interface: one heap token per call.
+static unsigned long long cMalloc(const std::string &data, long long *count)
+{
+    unsigned long long sum = 0;
+    Token *token;
+
+    openInputBuffer(reinterpret_cast<const unsigned char *>(data.data()), data.size());
+    initScanner();
+    while ((token = getToken())->tokenType != TK_EOF)
+    {
+        sum = fold(sum, *token);
+        ++*count;
+        freeToken(token);
+    }
+    freeToken(token);
+    return sum;
+}
+
+static unsigned long long cSlot(const std::string &data, long long *count)
+{
+    unsigned long long sum = 0;
+    Token token;
+
+    openInputBuffer(reinterpret_cast<const unsigned char *>(data.data()), data.size());
+    initScanner();
+    for (getTokenInto(&token); token.tokenType != TK_EOF; getTokenInto(&token))
+    {
+        sum = fold(sum, token);
+        ++*count;
+    }
+    return sum;
+}
+
+static unsigned long long cppRange(const std::string &data, long long *count)
+{
+    unsigned long long sum = 0;
+
+    for (Token &token : kpl::scanText(data))
+    {
+        sum = fold(sum, token);
+        ++*count;
+    }
+    return sum;
+}
+
+static unsigned long long cppGenerator(const std::string &data, long long *count)
+{
+    unsigned long long sum = 0;
+
+    for (Token &token : kpl::textTokens(data))
+    {
+        sum = fold(sum, token);
+        ++*count;
+    }
+    return sum;
+}
+
+int main(int argc, char *argv[])
+{
+    static const struct
+    {
+        const char *name;
+        Loop loop;
+    } loops[] = {
+        {"C getToken (malloc)", cMalloc},
+        {"C getTokenInto", cSlot},
+        {"C++ TokenRange", cppRange},
+        {"C++ Generator", cppGenerator},
+    };
+    const int loopCount = sizeof(loops) / sizeof(loops[0]);
+    double best[loopCount];
+    unsigned long long sums[loopCount];
+    long long tokens = 0;
+    int rounds = 5;
+    const char *fileName = NULL;
+    int i, round;
+
+    for (i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "-r") == 0 && i + 1 < argc)
+            rounds = atoi(argv[++i]);
+        else
+            fileName = argv[i];
+    }
+    if (fileName == NULL)
+    {
+        printf("Usage: rangebench [-r N] FILE\n");
+        return -1;
+    }
+
+    std::ifstream in(fileName, std::ios::binary);
+    std::string data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    if (!in.good() && !in.eof())
+    {
+        printf("Can\'t read %s\n", fileName);
+        return -1;
+    }
+
+    for (i = 0; i < loopCount; i++)
+        best[i] = 1e30;
+
+    // Interleave the loops so that drift in machine speed hits all of them.
+    for (round = 0; round < rounds; round++)
+    {
+        for (i = 0; i < loopCount; i++)
+        {
+            long long count = 0;
+            auto start = std::chrono::steady_clock::now();
+            sums[i] = loops[i].loop(data, &count);
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+            if (seconds < best[i])
+                best[i] = seconds;
+            tokens = count;
+        }
+    }
+
+    printf("%lld tokens, best of %d rounds\n", tokens, rounds);
+    if (tokens == 0)
+        tokens = 1;
+    for (i = 0; i < loopCount; i++)
+        printf("%-22s %8.2f ns/token  %5.2fx  %s\n", loops[i].name, best[i] * 1e9 / tokens,
+               best[i] / best[1], sums[i] == sums[1] ? "ok" : "CHECKSUM MISMATCH");
+
+    for (i = 0; i < loopCount; i++)
+        if (sums[i] != sums[1])
+            return 1;
+    return 0;
+}
@@ -0,0 +1,762 @@
+/*
+ * @copyright (c) 2026, agent
+ * @author agent
+ * @version 1.0
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <setjmp.h>
+#include <threads.h>
+#include <stdatomic.h>
+
+#include "reader.h"
+#include "token.h"
+#include "error.h"
+#include "trace.h"
+#include "memtrack.h"
+#include "platform.h"
+#include "scanner.h"
+#include "archive.h"
+#include "analytics.h"
+
+#define MAX_THREADS 64
+
+typedef struct
+{
+    char *name;
+    int length, nameCapacity;
+    unsigned hash;
+    long long count;
+    long long error;  // how much of count may belong to evicted names
+    int heapIndex;
+} Counter;
+
+/// <summary>
+/// Space-Saving summary of identifier frequencies: once all counters are in
+/// use, a new name takes over the smallest one and inherits its count as
+/// error, so counts never fall short of the truth.
+/// </summary>
+typedef struct
+{
+    Counter *counters;
+    int count, capacity;
+    int *slots;  // open addressing on name: counter index + 1, or 0
+    int slotMask;
+    int *heap;   // counter indices, a min-heap on count
+} HeavyHitters;
+
+/// <summary>
+/// An entry of a short ranked list, with its first place in the corpus.
+/// </summary>
+typedef struct
+{
+    char *text;
+    int length;
+    int fileIndex, lineNo, colNo;
+} Ranked;
+
+// Negative when a ranks before b.
+typedef int (*RankOrder)(const Ranked *a, const Ranked *b);
+
+/// <summary>
+/// One thread's metrics; merged into the first one at the end.
+/// </summary>
+typedef struct
+{
+    long long tokenCounts[TOKEN_TYPE_COUNT];
+    long long files, failed, bytes, lines;
+    long long comments, commentBytes;
+    long long nearMax;
+    long long *numberLengths;  // by digit count, up to maxNumLen
+    HeavyHitters identifiers;
+    Ranked longest[ANALYTICS_LONGEST];
+    int longestCount;
+    Ranked largest[ANALYTICS_LONGEST];
+    int largestCount;
+    char *text;  // the current lexeme, folded and NUL-terminated
+    int outOfMemory;
+} Accumulator;
+
+static char **inputNames;
+static Archive *inputArchive;
+static int inputCount;
+static atomic_int nextInput;
+
+static THREAD_LOCAL Accumulator *current;
+static THREAD_LOCAL int currentInput;
+static THREAD_LOCAL jmp_buf inputJump;
+
+/***************************************************************/
+
+static unsigned hashName(const char *name, int length)
+{
+    unsigned hash = 2166136261u;
+    int i;
+
+    for (i = 0; i < length; i++)
+    {
+        hash ^= (unsigned char)name[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static int initHeavyHitters(HeavyHitters *hh, int capacity)
+{
+    int slotCount = 1;
+
+    while (slotCount < capacity * 2)
+        slotCount *= 2;
+    hh->count = 0;
+    hh->capacity = capacity;
+    hh->slotMask = slotCount - 1;
+    hh->counters = (Counter *)memCalloc(MEM_ANALYTICS, capacity, sizeof(Counter));
+    hh->slots = (int *)memCalloc(MEM_ANALYTICS, slotCount, sizeof(int));
+    hh->heap = (int *)memAlloc(MEM_ANALYTICS, capacity * sizeof(int));
+    return hh->counters != NULL && hh->slots != NULL && hh->heap != NULL ? IO_SUCCESS : IO_ERROR;
+}
+
+static void freeHeavyHitters(HeavyHitters *hh)
+{
+    int i;
+
+    for (i = 0; hh->counters != NULL && i < hh->count; i++)
+        memFree(hh->counters[i].name);
+    memFree(hh->counters);
+    memFree(hh->slots);
+    memFree(hh->heap);
+}
+
+static void swapHeap(HeavyHitters *hh, int i, int j)
+{
+    int counter = hh->heap[i];
+
+    hh->heap[i] = hh->heap[j];
+    hh->heap[j] = counter;
+    hh->counters[hh->heap[i]].heapIndex = i;
+    hh->counters[hh->heap[j]].heapIndex = j;
+}
+
+static void siftUp(HeavyHitters *hh, int i)
+{
+    while (i > 0 && hh->counters[hh->heap[i]].count < hh->counters[hh->heap[(i - 1) / 2]].count)
+    {
+        swapHeap(hh, i, (i - 1) / 2);
+        i = (i - 1) / 2;
+    }
+}
+
+static void siftDown(HeavyHitters *hh, int i)
+{
+    int child;
+
+    while ((child = 2 * i + 1) < hh->count)
+    {
+        if (child + 1 < hh->count && hh->counters[hh->heap[child + 1]].count < hh->counters[hh->heap[child]].count)
+            child++;
+        if (hh->counters[hh->heap[i]].count <= hh->counters[hh->heap[child]].count)
+            break;
+        swapHeap(hh, i, child);
+        i = child;
+    }
+}
+
+/// <summary>
+/// The slot holding name, or the empty slot where it would go.
+/// </summary>
+static int findSlot(HeavyHitters *hh, const char *name, int length, unsigned hash)
+{
+    int slot = (int)(hash & (unsigned)hh->slotMask);
+    Counter *counter;
+
+    while (hh->slots[slot] != 0)
+    {
+        counter = &hh->counters[hh->slots[slot] - 1];
+        if (counter->hash == hash && counter->length == length && memcmp(counter->name, name, length) == 0)
+            break;
+        slot = (slot + 1) & hh->slotMask;
+    }
+    return slot;
+}
+
+/// <summary>
+/// Empty a slot, moving later entries of its probe run back into the gap.
+/// </summary>
+static void clearSlot(HeavyHitters *hh, int slot)
+{
+    int next = slot;
+    int home;
+
+    while (1)
+    {
+        next = (next + 1) & hh->slotMask;
+        if (hh->slots[next] == 0)
+            break;
+        home = (int)(hh->counters[hh->slots[next] - 1].hash & (unsigned)hh->slotMask);
+        // Move it unless its home lies cyclically in (slot, next].
+        if ((slot <= next) ? (home <= slot || home > next) : (home <= slot && home > next))
+        {
+            hh->slots[slot] = hh->slots[next];
+            slot = next;
+        }
+    }
+    hh->slots[slot] = 0;
+}
+
+static int setCounterName(Counter *counter, const char *name, int length, unsigned hash)
+{
+    char *grown;
+
+    if (counter->nameCapacity < length + 1)
+    {
+        grown = (char *)memRealloc(MEM_ANALYTICS, counter->name, length + 1);
+        if (grown == NULL)
+            return IO_ERROR;
+        counter->name = grown;
+        counter->nameCapacity = length + 1;
+    }
+    memcpy(counter->name, name, length);
+    counter->name[length] = '\0';
+    counter->length = length;
+    counter->hash = hash;
+    return IO_SUCCESS;
+}
+
+/// <summary>
+/// Count one occurrence of name, evicting the least counted name when full.
+/// </summary>
+static int countName(HeavyHitters *hh, const char *name, int length, long long count, long long error)
+{
+    unsigned hash = hashName(name, length);
+    int slot = findSlot(hh, name, length, hash);
+    Counter *counter;
+    int i;
+
+    if (hh->slots[slot] != 0)
+    {
+        counter = &hh->counters[hh->slots[slot] - 1];
+        counter->count += count;
+        counter->error += error;
+        siftDown(hh, counter->heapIndex);
+        return IO_SUCCESS;
+    }
+
+    if (hh->count < hh->capacity)
+    {
+        i = hh->count++;
+        counter = &hh->counters[i];
+        if (setCounterName(counter, name, length, hash) == IO_ERROR)
+        {
+            hh->count--;
+            return IO_ERROR;
+        }
+        counter->count = count;
+        counter->error = error;
+        counter->heapIndex = i;
+        hh->heap[i] = i;
+        siftUp(hh, i);
+        hh->slots[slot] = i + 1;
+        return IO_SUCCESS;
+    }
+
+    i = hh->heap[0];
+    counter = &hh->counters[i];
+    clearSlot(hh, findSlot(hh, counter->name, counter->length, counter->hash));
+    if (setCounterName(counter, name, length, hash) == IO_ERROR)
+        return IO_ERROR;
+    counter->error = counter->count + error;
+    counter->count += count;
+    siftDown(hh, 0);
+    hh->slots[findSlot(hh, name, length, hash)] = i + 1;
+    return IO_SUCCESS;
+}
+
+/// <summary>
+/// Smallest count a name missing from a full summary may still have had.
+/// </summary>
+static long long missingCount(HeavyHitters *hh)
+{
+    return hh->count == hh->capacity ? hh->counters[hh->heap[0]].count : 0;
+}
+
+/***************************************************************/
+
+static int comparePlace(const Ranked *a, const Ranked *b)
+{
+    if (a->fileIndex != b->fileIndex)
+        return a->fileIndex < b->fileIndex ? -1 : 1;
+    if (a->lineNo != b->lineNo)
+        return a->lineNo < b->lineNo ? -1 : 1;
+    return a->colNo < b->colNo ? -1 : a->colNo > b->colNo;
+}
+
+static int longerFirst(const Ranked *a, const Ranked *b)
+{
+    int order;
+
+    if (a->length != b->length)
+        return b->length - a->length;
+    order = strcmp(a->text, b->text);
+    return order != 0 ? order : comparePlace(a, b);
+}
+
+static int largerFirst(const Ranked *a, const Ranked *b)
+{
+    int order;
+
+    if (a->length != b->length)
+        return b->length - a->length;
+    order = strcmp(b->text, a->text);
+    return order != 0 ? order : comparePlace(a, b);
+}
+
+/// <summary>
+/// Offer a candidate to a ranked list of distinct texts. A text already
+/// listed only moves to the earlier of its places.
+/// </summary>
+static int offerRanked(Ranked *list, int *count, const Ranked *candidate, RankOrder order)
+{
+    char *text;
+    int i;
+
+    if (*count == ANALYTICS_LONGEST && order(candidate, &list[*count - 1]) >= 0)
+        return IO_SUCCESS;
+
+    for (i = 0; i < *count; i++)
+    {
+        if (list[i].length == candidate->length && strcmp(list[i].text, candidate->text) == 0)
+        {
+            if (comparePlace(candidate, &list[i]) < 0)
+            {
+                list[i].fileIndex = candidate->fileIndex;
+                list[i].lineNo = candidate->lineNo;
+                list[i].colNo = candidate->colNo;
+            }
+            return IO_SUCCESS;
+        }
+    }
+
+    text = (char *)memAlloc(MEM_ANALYTICS, candidate->length + 1);
+    if (text == NULL)
+        return IO_ERROR;
+    memcpy(text, candidate->text, candidate->length + 1);
+
+    if (*count == ANALYTICS_LONGEST)
+        memFree(list[--*count].text);
+    for (i = *count; i > 0 && order(candidate, &list[i - 1]) < 0; i--)
+        list[i] = list[i - 1];
+    list[i] = *candidate;
+    list[i].text = text;
+    ++*count;
+    return IO_SUCCESS;
+}
+
+/***************************************************************/
+
+static int initAccumulator(Accumulator *acc)
+{
+    int textSize = (maxIdentLen > maxNumLen ? maxIdentLen : maxNumLen) + 1;
+
+    memset(acc, 0, sizeof(*acc));
+    acc->numberLengths = (long long *)memCalloc(MEM_ANALYTICS, maxNumLen + 1, sizeof(long long));
+    acc->text = (char *)memAlloc(MEM_ANALYTICS, textSize);
+    if (initHeavyHitters(&acc->identifiers, ANALYTICS_COUNTERS) == IO_ERROR ||
+        acc->numberLengths == NULL || acc->text == NULL)
+        return IO_ERROR;
+    return IO_SUCCESS;
+}
+
+static void freeAccumulator(Accumulator *acc)
+{
+    int i;
+
+    for (i = 0; i < acc->longestCount; i++)
+        memFree(acc->longest[i].text);
+    for (i = 0; i < acc->largestCount; i++)
+        memFree(acc->largest[i].text);
+    freeHeavyHitters(&acc->identifiers);
+    memFree(acc->numberLengths);
+    memFree(acc->text);
+}
+
+/// <summary>
+/// TokenSink while analyzing; tokenFilter lets only identifiers and numbers
+/// through, everything else is just counted by the lexer.
+/// </summary>
+static void analyzeToken(Token *token)
+{
+    Accumulator *acc = current;
+    const char *lexeme = token->lexeme;
+    Ranked candidate;
+    int i, status;
+
+    candidate.text = acc->text;
+    candidate.length = token->length;
+    candidate.fileIndex = currentInput;
+    candidate.lineNo = token->lineNo;
+    candidate.colNo = token->colNo;
+
+    if (token->tokenType == TK_IDENT)
+    {
+        // Identifiers are not case-sensitive, so fold them as the index does.
+        for (i = 0; i < token->length; i++)
+            acc->text[i] = (char)toupper((unsigned char)lexeme[i]);
+        acc->text[token->length] = '\0';
+
+        status = countName(&acc->identifiers, acc->text, token->length, 1, 0);
+        if (status == IO_SUCCESS)
+            status = offerRanked(acc->longest, &acc->longestCount, &candidate, longerFirst);
+    }
+    else
+    {
+        acc->numberLengths[token->length]++;
+        if (token->length < maxNumLen - ANALYTICS_NEAR_DIGITS)
+            return;
+
+        acc->nearMax++;
+        memcpy(acc->text, lexeme, token->length);
+        acc->text[token->length] = '\0';
+        status = offerRanked(acc->largest, &acc->largestCount, &candidate, largerFirst);
+    }
+
+    if (status == IO_ERROR)
+        acc->outOfMemory = 1;
+}
+
+/// <summary>
+/// errorHook while analyzing: give up on this input only.
+/// </summary>
+static void stopInput(ErrorCode err, int lineNo, int colNo)
+{
+    longjmp(inputJump, 1);
+}
+
+static const char *inputName(int index)
+{
+    return inputArchive != NULL ? archiveEntryName(inputArchive, index) : inputNames[index];
+}
+
+static int openInput(int index)
+{
+    const unsigned char *data;
+    size_t len;
+
+    if (inputArchive == NULL)
+        return openInputStream(inputNames[index]);
+
+    data = archiveEntryData(inputArchive, index, &len);
+    if (archiveHash(data, len) != archiveEntryHash(inputArchive, index))
+        return IO_ERROR;
+    openInputBuffer(data, len);
+    return IO_SUCCESS;
+}
+
+static int analyticsWorker(void *arg)
+{
+    Accumulator *acc = (Accumulator *)arg;
+    int failed, type, i;
+
+    current = acc;
+    tokenSink = analyzeToken;
+    errorHook = stopInput;
+
+    while ((i = atomic_fetch_add(&nextInput, 1)) < inputCount)
+    {
+        currentInput = i;
+        acc->files++;
+        if (openInput(i) == IO_ERROR)
+        {
+            acc->failed++;
+            continue;
+        }
+
+        failed = 1;
+        if (setjmp(inputJump) == 0)
+            failed = scanTokens((char *)inputName(i)) != IO_SUCCESS;
+        acc->failed += failed;
+
+        for (type = 0; type < TOKEN_TYPE_COUNT; type++)
+            acc->tokenCounts[type] += tokenCounts[type];
+        acc->comments += commentCount;
+        acc->commentBytes += commentBytes;
+        // What was lexed: all of the input unless it failed.
+        acc->bytes += currentChar == EOF ? inputOffset() + 1 : inputOffset();
+        acc->lines += colNo > 1 ? lineNo : lineNo - 1;
+
+        if (inputArchive == NULL)
+            closeInputStream();
+    }
+
+    freeInputBuffer();
+    tokenSink = printToken;
+    errorHook = NULL;
+    return 0;
+}
+
+/***************************************************************/
+
+typedef struct
+{
+    const Counter *counter;
+    int thread;
+} CounterRef;
+
+typedef struct
+{
+    const char *name;
+    long long count, error;
+} Frequency;
+
+static int compareCounterRefs(const void *a, const void *b)
+{
+    const CounterRef *x = (const CounterRef *)a;
+    const CounterRef *y = (const CounterRef *)b;
+
+    return strcmp(x->counter->name, y->counter->name);
+}
+
+static int compareFrequencies(const void *a, const void *b)
+{
+    const Frequency *x = (const Frequency *)a;
+    const Frequency *y = (const Frequency *)b;
+
+    if (x->count != y->count)
+        return x->count > y->count ? -1 : 1;
+    return strcmp(x->name, y->name);
+}
+
+/// <summary>
+/// Merge the threads' summaries: a name missing from a full summary may
+/// have been evicted there, so it gets that summary's smallest count as
+/// both count and error. Returns the merged frequencies, most frequent first.
+/// </summary>
+static Frequency *mergeFrequencies(Accumulator *accs, int threadCount, int *frequencyCount)
+{
+    CounterRef *refs;
+    Frequency *frequencies;
+    long long missing = 0, present;
+    int total = 0, count = 0;
+    int i, j, k;
+
+    for (i = 0; i < threadCount; i++)
+    {
+        total += accs[i].identifiers.count;
+        missing += missingCount(&accs[i].identifiers);
+    }
+
+    refs = (CounterRef *)memAlloc(MEM_ANALYTICS, (total > 0 ? total : 1) * sizeof(CounterRef));
+    frequencies = (Frequency *)memAlloc(MEM_ANALYTICS, (total > 0 ? total : 1) * sizeof(Frequency));
+    if (refs == NULL || frequencies == NULL)
+    {
+        memFree(refs);
+        memFree(frequencies);
+        return NULL;
+    }
+    for (i = 0, k = 0; i < threadCount; i++)
+        for (j = 0; j < accs[i].identifiers.count; j++)
+        {
+            refs[k].counter = &accs[i].identifiers.counters[j];
+            refs[k++].thread = i;
+        }
+    qsort(refs, total, sizeof(CounterRef), compareCounterRefs);
+
+    for (i = 0; i < total; i = j)
+    {
+        frequencies[count].name = refs[i].counter->name;
+        frequencies[count].count = frequencies[count].error = missing;
+        for (j = i; j < total && strcmp(refs[j].counter->name, refs[i].counter->name) == 0; j++)
+        {
+            present = missingCount(&accs[refs[j].thread].identifiers);
+            frequencies[count].count += refs[j].counter->count - present;
+            frequencies[count].error += refs[j].counter->error - present;
+        }
+        count++;
+    }
+    memFree(refs);
+
+    qsort(frequencies, count, sizeof(Frequency), compareFrequencies);
+    *frequencyCount = count;
+    return frequencies;
+}
+
+/// <summary>
+/// Fold the other threads' accumulators into accs[0].
+/// </summary>
+static int mergeAccumulators(Accumulator *accs, int threadCount)
+{
+    Accumulator *into = &accs[0];
+    int i, j;
+
+    for (i = 1; i < threadCount; i++)
+    {
+        for (j = 0; j < TOKEN_TYPE_COUNT; j++)
+            into->tokenCounts[j] += accs[i].tokenCounts[j];
+        for (j = 0; j <= maxNumLen; j++)
+            into->numberLengths[j] += accs[i].numberLengths[j];
+        into->files += accs[i].files;
+        into->failed += accs[i].failed;
+        into->bytes += accs[i].bytes;
+        into->lines += accs[i].lines;
+        into->comments += accs[i].comments;
+        into->commentBytes += accs[i].commentBytes;
+        into->nearMax += accs[i].nearMax;
+        into->outOfMemory |= accs[i].outOfMemory;
+
+        for (j = 0; j < accs[i].longestCount; j++)
+            if (offerRanked(into->longest, &into->longestCount, &accs[i].longest[j], longerFirst) == IO_ERROR)
+                return IO_ERROR;
+        for (j = 0; j < accs[i].largestCount; j++)
+            if (offerRanked(into->largest, &into->largestCount, &accs[i].largest[j], largerFirst) == IO_ERROR)
+                return IO_ERROR;
+    }
+    return into->outOfMemory ? IO_ERROR : IO_SUCCESS;
+}
+
+/***************************************************************/
+
+static void writeJsonString(FILE *out, const char *s)
+{
+    fputc('"', out);
+    for (; *s != '\0'; s++)
+    {
+        if (*s == '"' || *s == '\\')
+            fprintf(out, "\\%c", *s);
+        else if ((unsigned char)*s < 0x20)
+            fprintf(out, "\\u%04x", (unsigned char)*s);
+        else
+            fputc(*s, out);
+    }
+    fputc('"', out);
+}
+
+static void writeRanked(FILE *out, const char *key, const Ranked *list, int count)
+{
+    int i;
+
+    fprintf(out, "[");
+    for (i = 0; i < count; i++)
+    {
+        fprintf(out, "%s\n      {\"%s\": ", i > 0 ? "," : "", key);
+        writeJsonString(out, list[i].text);
+        fprintf(out, ", \"length\": %d, \"file\": ", list[i].length);
+        writeJsonString(out, inputName(list[i].fileIndex));
+        fprintf(out, ", \"line\": %d, \"col\": %d}", list[i].lineNo, list[i].colNo);
+    }
+    fprintf(out, count > 0 ? "\n    ]" : "]");
+}
+
+static void writeReport(FILE *out, Accumulator *acc, Frequency *frequencies, int frequencyCount, int top)
+{
+    long long tokens = 0, codeBytes = acc->bytes - acc->commentBytes;
+    int i;
+
+    for (i = 0; i < TOKEN_TYPE_COUNT; i++)
+        tokens += acc->tokenCounts[i];
+
+    fprintf(out, "{\n");
+    fprintf(out, "  \"files\": %lld,\n  \"failed\": %lld,\n", acc->files, acc->failed);
+    fprintf(out, "  \"bytes\": %lld,\n  \"lines\": %lld,\n  \"tokens\": %lld,\n", acc->bytes, acc->lines, tokens);
+
+    fprintf(out, "  \"tokenTypes\": {");
+    for (i = 0; i < TOKEN_TYPE_COUNT; i++)
+        if (i != TK_EOF)
+            fprintf(out, "%s\n    \"%s\": %lld", i > 0 ? "," : "", tokenTypeName((TokenType)i), acc->tokenCounts[i]);
+    fprintf(out, "\n  },\n");
+
+    fprintf(out, "  \"comments\": {\"count\": %lld, \"bytes\": %lld, \"codeBytes\": %lld, \"ratio\": %.4f},\n",
+            acc->comments, acc->commentBytes, codeBytes, codeBytes > 0 ? (double)acc->commentBytes / codeBytes : 0.0);
+
+    fprintf(out, "  \"identifiers\": {\n    \"total\": %lld,\n    \"top\": [", acc->tokenCounts[TK_IDENT]);
+    for (i = 0; i < top && i < frequencyCount; i++)
+    {
+        fprintf(out, "%s\n      {\"name\": ", i > 0 ? "," : "");
+        writeJsonString(out, frequencies[i].name);
+        fprintf(out, ", \"count\": %lld, \"error\": %lld}", frequencies[i].count, frequencies[i].error);
+    }
+    fprintf(out, i > 0 ? "\n    ],\n" : "],\n");
+    fprintf(out, "    \"longest\": ");
+    writeRanked(out, "name", acc->longest, acc->longestCount);
+    fprintf(out, "\n  },\n");
+
+    fprintf(out, "  \"numbers\": {\n    \"total\": %lld,\n    \"maxLength\": %d,\n    \"lengths\": [",
+            acc->tokenCounts[TK_NUMBER], maxNumLen);
+    for (i = 0; i <= maxNumLen; i++)
+        fprintf(out, "%s%lld", i > 0 ? ", " : "", acc->numberLengths[i]);
+    fprintf(out, "],\n    \"nearMax\": %lld,\n    \"largest\": ", acc->nearMax);
+    writeRanked(out, "text", acc->largest, acc->largestCount);
+    fprintf(out, "\n  }\n}\n");
+}
+
+int analyzeCorpus(char **fileNames, int fileCount, Archive *archive, int threadCount, int top, FILE *out,
+                  int *failed)
+{
+    thrd_t threads[MAX_THREADS];
+    Accumulator accs[MAX_THREADS];
+    TokenSink savedSink = tokenSink;
+    void (*savedErrorHook)(ErrorCode err, int lineNo, int colNo) = errorHook;
+    TokenMask savedFilter = tokenFilter;
+    int savedCount = countTokens;
+    int savedOptions = scanOptions;
+    Frequency *frequencies = NULL;
+    int frequencyCount = 0;
+    int i, started, status = IO_SUCCESS;
+
+    inputNames = fileNames;
+    inputArchive = archive;
+    inputCount = archive != NULL ? archiveEntryCount(archive) : fileCount;
+    if (threadCount < 1)
+        threadCount = 1;
+    if (threadCount > MAX_THREADS)
+        threadCount = MAX_THREADS;
+
+    for (i = 0; i < threadCount; i++)
+        if (initAccumulator(&accs[i]) == IO_ERROR)
+            status = IO_ERROR;
+
+    if (status == IO_SUCCESS)
+    {
+        // Only the tokens with a lexeme worth looking at reach the sink; the
+        // rest are counted by type inside the lexer. Places need positions.
+        tokenFilter = TOKEN_BIT(TK_IDENT) | TOKEN_BIT(TK_NUMBER);
+        countTokens = 1;
+        scanOptions = SCAN_DEFAULT;
+        atomic_init(&nextInput, 0);
+
+        TRACE_BEGIN(lexStart);
+        for (started = 0; started < threadCount; started++)
+            if (thrd_create(&threads[started], analyticsWorker, &accs[started]) != thrd_success)
+                break;
+        for (i = 0; i < started; i++)
+            thrd_join(threads[i], NULL);
+        // No thread could be started: scan on this one.
+        if (started == 0)
+            analyticsWorker(&accs[started++]);
+        TRACE_END(lexStart, "analyze", "corpus");
+
+        tokenSink = savedSink;
+        errorHook = savedErrorHook;
+        tokenFilter = savedFilter;
+        countTokens = savedCount;
+        scanOptions = savedOptions;
+
+        TRACE_BEGIN(mergeStart);
+        frequencies = mergeFrequencies(accs, started, &frequencyCount);
+        if (frequencies == NULL || mergeAccumulators(accs, started) == IO_ERROR)
+            status = IO_ERROR;
+        TRACE_END(mergeStart, "merge", "corpus");
+    }
+
+    if (status == IO_SUCCESS)
+    {
+        writeReport(out, &accs[0], frequencies, frequencyCount, top);
+        *failed = (int)accs[0].failed;
+    }
+
+    memFree(frequencies);
+    for (i = 0; i < threadCount; i++)
+        freeAccumulator(&accs[i]);
+    return status;
+}
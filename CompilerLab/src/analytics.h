@@ -0,0 +1,35 @@
+/*
+ * @copyright (c) 2026, agent
+ * @author agent
+ * @version 1.0
+ */
+
+#ifndef __ANALYTICS_H__
+#define __ANALYTICS_H__
+
+#include <stdio.h>
+#include "archive.h"
+
+#define ANALYTICS_THREADS 4
+// Space-Saving counters per thread for identifier frequencies. Counts are
+// exact while a thread meets no more distinct identifiers than this.
+#define ANALYTICS_COUNTERS 4096
+// Heavy hitters reported by default.
+#define ANALYTICS_TOP 20
+// Longest identifiers and numbers near maxNumLen reported.
+#define ANALYTICS_LONGEST 10
+// Numbers at most this many digits short of maxNumLen are near it.
+#define ANALYTICS_NEAR_DIGITS 1
+
+// Lex fileNames, or every entry of archive when it is not NULL, on
+// threadCount threads and write lexical metrics of the whole corpus to out
+// as one JSON object: token type totals, comment to code ratio, the top
+// most frequent identifiers, the longest identifiers and the numbers
+// nearest maxNumLen. Each thread keeps its own accumulators; they are
+// merged once all files are done. Files stopped by a lexical error count
+// as failed and contribute the tokens before it. Returns IO_ERROR if the
+// accumulators can't be allocated.
+int analyzeCorpus(char **fileNames, int fileCount, Archive *archive, int threadCount, int top, FILE *out,
+                  int *failed);
+
+#endif
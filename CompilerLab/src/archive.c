@@ -0,0 +1,525 @@
+/*
+ * @copyright (c) 2026, agent
+ * @author agent
+ * @version 1.0
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <setjmp.h>
+#include <threads.h>
+#include <stdatomic.h>
+#ifndef _MSC_VER
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#include "reader.h"
+#include "error.h"
+#include "trace.h"
+#include "memtrack.h"
+#include "platform.h"
+#include "scanner.h"
+#include "archive.h"
+
+#define ARCHIVE_MAGIC "KPLPAK1"
+#define ARCHIVE_VERSION 1
+#define MAX_THREADS 64
+#define COPY_CHUNK_SIZE 65536
+
+/*
+ * Archive file layout, all integers in host byte order:
+ *
+ *   ArchiveHeader
+ *   ArchiveEntry[entryCount]   in the order the files were packed
+ *   names                      NUL-terminated original file names
+ *   contents                   each entry's bytes, starting on an
+ *                              ARCHIVE_ALIGN boundary
+ */
+
+typedef struct
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t entryCount;
+    uint64_t entryTable;
+    uint64_t names;
+    uint64_t contents;
+    uint64_t size;
+} ArchiveHeader;
+
+typedef struct
+{
+    uint64_t offset;
+    uint64_t length;
+    uint64_t hash;
+    uint32_t name;
+    uint32_t nameLength;
+} ArchiveEntry;
+
+struct Archive
+{
+    unsigned char *data;
+    size_t size;
+    const ArchiveHeader *header;
+    const ArchiveEntry *entries;
+    const char *names;
+};
+
+/// <summary>
+/// Where a scanned entry's output ended up, and how the scan went.
+/// </summary>
+typedef struct
+{
+    FILE *output;     // the worker's file, or NULL if printed directly
+    long start, end;  // byte range of its output there
+    int failed;
+} EntryState;
+
+static Archive *scanArchive;
+static EntryState *entryStates;
+static ArchiveEntryDone entryDoneHook;
+static atomic_int nextEntry;
+
+static THREAD_LOCAL jmp_buf entryJump;
+
+/***************************************************************/
+
+uint64_t archiveHash(const unsigned char *data, size_t len)
+{
+    uint64_t hash = 14695981039346656037ULL;
+    size_t i;
+
+    for (i = 0; i < len; i++)
+    {
+        hash ^= data[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+static uint64_t alignUp(uint64_t offset)
+{
+    return (offset + ARCHIVE_ALIGN - 1) & ~(uint64_t)(ARCHIVE_ALIGN - 1);
+}
+
+/// <summary>
+/// Append one file to the archive at its current end. Returns the number of
+/// bytes copied through *len and their hash through *hash.
+/// </summary>
+static int packFile(FILE *out, char *fileName, uint64_t *len, uint64_t *hash)
+{
+    unsigned char buffer[COPY_CHUNK_SIZE];
+    uint64_t h = 14695981039346656037ULL;
+    size_t n, i;
+    FILE *in;
+
+#ifdef _MSC_VER
+    fopen_s(&in, fileName, "rb");
+#else
+    in = fopen(fileName, "rb");
+#endif
+    if (in == NULL)
+        return IO_ERROR;
+
+    *len = 0;
+    while ((n = fread(buffer, 1, sizeof(buffer), in)) > 0)
+    {
+        // The same FNV-1a as archiveHash, carried across chunks.
+        for (i = 0; i < n; i++)
+        {
+            h ^= buffer[i];
+            h *= 1099511628211ULL;
+        }
+        if (fwrite(buffer, 1, n, out) != n)
+        {
+            fclose(in);
+            return IO_ERROR;
+        }
+        *len += n;
+    }
+    *hash = h;
+
+    if (ferror(in))
+    {
+        fclose(in);
+        return IO_ERROR;
+    }
+    fclose(in);
+    return IO_SUCCESS;
+}
+
+int archivePack(char *archiveName, char **fileNames, int count)
+{
+    static const unsigned char padding[ARCHIVE_ALIGN] = {0};
+    ArchiveHeader header;
+    ArchiveEntry *entries;
+    uint64_t offset, namesLen = 0;
+    int i, status = IO_SUCCESS;
+    FILE *out;
+
+    entries = (ArchiveEntry *)memCalloc(MEM_INDEX, count > 0 ? count : 1, sizeof(ArchiveEntry));
+    if (entries == NULL)
+        return IO_ERROR;
+    for (i = 0; i < count; i++)
+    {
+        entries[i].name = (uint32_t)namesLen;
+        entries[i].nameLength = (uint32_t)strlen(fileNames[i]);
+        namesLen += entries[i].nameLength + 1;
+    }
+
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, ARCHIVE_MAGIC, sizeof(header.magic));
+    header.version = ARCHIVE_VERSION;
+    header.entryCount = (uint32_t)count;
+    header.entryTable = sizeof(ArchiveHeader);
+    header.names = header.entryTable + (uint64_t)count * sizeof(ArchiveEntry);
+    header.contents = alignUp(header.names + namesLen);
+
+#ifdef _MSC_VER
+    fopen_s(&out, archiveName, "wb");
+#else
+    out = fopen(archiveName, "wb");
+#endif
+    if (out == NULL)
+    {
+        memFree(entries);
+        return IO_ERROR;
+    }
+
+    // Contents first, so that the table is written once offsets are known.
+    TRACE_BEGIN(packStart);
+    offset = header.contents;
+    if (fseek(out, (long)offset, SEEK_SET) != 0)
+        status = IO_ERROR;
+    for (i = 0; i < count && status == IO_SUCCESS; i++)
+    {
+        entries[i].offset = offset;
+        if (packFile(out, fileNames[i], &entries[i].length, &entries[i].hash) == IO_ERROR)
+        {
+            printf("Can\'t read input file %s!\n", fileNames[i]);
+            status = IO_ERROR;
+            break;
+        }
+        offset += entries[i].length;
+        if (alignUp(offset) > offset && fwrite(padding, 1, (size_t)(alignUp(offset) - offset), out) != alignUp(offset) - offset)
+            status = IO_ERROR;
+        offset = alignUp(offset);
+    }
+    header.size = offset;
+    TRACE_END(packStart, "pack", archiveName);
+
+    if (status == IO_SUCCESS)
+    {
+        if (fseek(out, 0, SEEK_SET) != 0 || fwrite(&header, sizeof(header), 1, out) != 1 ||
+            fwrite(entries, sizeof(ArchiveEntry), count, out) != (size_t)count)
+            status = IO_ERROR;
+        for (i = 0; i < count && status == IO_SUCCESS; i++)
+            if (fwrite(fileNames[i], 1, entries[i].nameLength + 1, out) != entries[i].nameLength + 1)
+                status = IO_ERROR;
+        offset = header.names + namesLen;
+        if (status == IO_SUCCESS && header.contents > offset &&
+            fwrite(padding, 1, (size_t)(header.contents - offset), out) != header.contents - offset)
+            status = IO_ERROR;
+    }
+    if (fclose(out) != 0)
+        status = IO_ERROR;
+    if (status == IO_ERROR)
+        remove(archiveName);
+
+    memFree(entries);
+    return status;
+}
+
+/***************************************************************/
+
+Archive *archiveOpen(const char *archiveName)
+{
+    Archive *archive = (Archive *)memCalloc(MEM_INDEX, 1, sizeof(Archive));
+    const ArchiveHeader *header;
+    uint32_t i;
+
+    if (archive == NULL)
+        return NULL;
+
+#ifdef _MSC_VER
+    {
+        FILE *f;
+        long size;
+
+        fopen_s(&f, archiveName, "rb");
+        if (f == NULL || fseek(f, 0, SEEK_END) != 0 || (size = ftell(f)) < 0 || fseek(f, 0, SEEK_SET) != 0)
+        {
+            if (f != NULL)
+                fclose(f);
+            memFree(archive);
+            return NULL;
+        }
+        archive->size = (size_t)size;
+        archive->data = (unsigned char *)memAlloc(MEM_INPUT, archive->size + 1);
+        if (archive->data == NULL || fread(archive->data, 1, archive->size, f) != archive->size)
+        {
+            fclose(f);
+            memFree(archive->data);
+            memFree(archive);
+            return NULL;
+        }
+        fclose(f);
+    }
+#else
+    {
+        struct stat st;
+        void *map;
+        int fd = open(archiveName, O_RDONLY);
+
+        if (fd < 0 || fstat(fd, &st) != 0 || st.st_size == 0)
+        {
+            if (fd >= 0)
+                close(fd);
+            memFree(archive);
+            return NULL;
+        }
+        map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (map == MAP_FAILED)
+        {
+            memFree(archive);
+            return NULL;
+        }
+        archive->data = (unsigned char *)map;
+        archive->size = (size_t)st.st_size;
+    }
+#endif
+
+    header = (const ArchiveHeader *)archive->data;
+    if (archive->size < sizeof(ArchiveHeader) || memcmp(header->magic, ARCHIVE_MAGIC, sizeof(header->magic)) != 0 ||
+        header->version != ARCHIVE_VERSION || header->size != archive->size ||
+        header->entryTable < sizeof(ArchiveHeader) || header->entryTable > header->names ||
+        header->names > header->contents || header->contents > header->size ||
+        header->entryCount > (header->names - header->entryTable) / sizeof(ArchiveEntry))
+    {
+        archiveClose(archive);
+        return NULL;
+    }
+
+    archive->header = header;
+    archive->entries = (const ArchiveEntry *)(archive->data + header->entryTable);
+    archive->names = (const char *)(archive->data + header->names);
+
+    // Names are used as C strings and contents are lexed in place, so check
+    // that both stay inside their sections.
+    for (i = 0; i < header->entryCount; i++)
+    {
+        const ArchiveEntry *entry = &archive->entries[i];
+        if ((uint64_t)entry->name + entry->nameLength >= header->contents - header->names ||
+            archive->names[entry->name + entry->nameLength] != '\0' ||
+            entry->offset < header->contents || entry->offset > header->size ||
+            entry->length > header->size - entry->offset)
+            break;
+    }
+    if (i < header->entryCount)
+    {
+        archiveClose(archive);
+        return NULL;
+    }
+    return archive;
+}
+
+void archiveClose(Archive *archive)
+{
+    if (archive == NULL)
+        return;
+#ifdef _MSC_VER
+    memFree(archive->data);
+#else
+    munmap(archive->data, archive->size);
+#endif
+    memFree(archive);
+}
+
+int archiveEntryCount(Archive *archive)
+{
+    return (int)archive->header->entryCount;
+}
+
+const char *archiveEntryName(Archive *archive, int index)
+{
+    return archive->names + archive->entries[index].name;
+}
+
+const unsigned char *archiveEntryData(Archive *archive, int index, size_t *len)
+{
+    *len = (size_t)archive->entries[index].length;
+    return archive->data + archive->entries[index].offset;
+}
+
+uint64_t archiveEntryHash(Archive *archive, int index)
+{
+    return archive->entries[index].hash;
+}
+
+/***************************************************************/
+
+/// <summary>
+/// errorHook while scanning an archive: report the error in the entry's
+/// output and give up on that entry only.
+/// </summary>
+static void stopEntry(ErrorCode err, int lineNo, int colNo)
+{
+    printError(err, lineNo, colNo);
+    longjmp(entryJump, 1);
+}
+
+/// <summary>
+/// Lex one entry from the mapping into the current output.
+/// </summary>
+static void scanEntry(int index)
+{
+    char *name = (char *)archiveEntryName(scanArchive, index);
+    const unsigned char *data;
+    size_t len;
+    int status;
+
+    data = archiveEntryData(scanArchive, index, &len);
+    if (archiveHash(data, len) != archiveEntryHash(scanArchive, index))
+    {
+        fprintf(outputFile(), "Can\'t read input file!\n");
+        entryStates[index].failed = 1;
+        return;
+    }
+
+    if (setjmp(entryJump) != 0)
+    {
+        entryStates[index].failed = 1;
+        return;
+    }
+    status = scanBuffer(name, data, len);
+    if (status == SCAN_BUDGET_EXCEEDED)
+    {
+        printError(ERR_BUDGETEXCEEDED, lineNo, colNo);
+        entryStates[index].failed = 1;
+    }
+    if (entryDoneHook != NULL)
+        entryDoneHook(index, status);
+}
+
+/// <summary>
+/// Take entries until none are left. Output goes to the worker's file if it
+/// has one, else straight to the caller's output behind each entry's banner.
+/// </summary>
+static int archiveWorker(void *arg)
+{
+    FILE *out = (FILE *)arg;
+    FILE *savedOutput = outputStream;
+    void (*savedErrorHook)(ErrorCode err, int lineNo, int colNo) = errorHook;
+    int count = archiveEntryCount(scanArchive);
+    int i;
+
+    if (out != NULL)
+        outputStream = out;
+    errorHook = stopEntry;
+
+    while ((i = atomic_fetch_add(&nextEntry, 1)) < count)
+    {
+        if (out == NULL && count > 1)
+            fprintf(outputFile(), "==> %s <==\n", archiveEntryName(scanArchive, i));
+        entryStates[i].output = out;
+        entryStates[i].start = out != NULL ? ftell(out) : 0;
+        scanEntry(i);
+        fflush(outputFile());
+        entryStates[i].end = out != NULL ? ftell(out) : 0;
+    }
+
+    outputStream = savedOutput;
+    errorHook = savedErrorHook;
+    return 0;
+}
+
+/// <summary>
+/// Print one entry's buffered output under its banner.
+/// </summary>
+static void copyOutput(FILE *in, int index, int count)
+{
+    char buffer[COPY_CHUNK_SIZE];
+    long left = entryStates[index].end - entryStates[index].start;
+    size_t n;
+
+    if (count > 1)
+        fprintf(outputFile(), "==> %s <==\n", archiveEntryName(scanArchive, index));
+    if (fseek(in, entryStates[index].start, SEEK_SET) != 0)
+        return;
+    while (left > 0 && (n = fread(buffer, 1, left < (long)sizeof(buffer) ? (size_t)left : sizeof(buffer), in)) > 0)
+    {
+        fwrite(buffer, 1, n, outputFile());
+        left -= (long)n;
+    }
+}
+
+int archiveScan(Archive *archive, int threadCount, ArchiveEntryDone entryDone)
+{
+    thrd_t threads[MAX_THREADS];
+    FILE *outputs[MAX_THREADS];
+    void *buffers[MAX_THREADS];
+    int count = archiveEntryCount(archive);
+    int i, started = 0, status = 0;
+
+    entryStates = (EntryState *)memCalloc(MEM_OUTPUT, count > 0 ? count : 1, sizeof(EntryState));
+    if (entryStates == NULL)
+        return -1;
+    scanArchive = archive;
+    entryDoneHook = entryDone;
+    atomic_init(&nextEntry, 0);
+
+    if (threadCount > MAX_THREADS)
+        threadCount = MAX_THREADS;
+    if (threadCount > count)
+        threadCount = count;
+
+    // Each worker buffers its entries' output in a file of its own; the
+    // ranges are printed in archive order once all workers are done.
+    for (i = 0; threadCount > 1 && i < threadCount; i++)
+    {
+        if ((outputs[i] = tmpfile()) == NULL)
+            break;
+        buffers[i] = memBufferStream(outputs[i], BUFSIZ);
+    }
+    if (threadCount > 1 && i == threadCount)
+    {
+        for (started = 0; started < threadCount; started++)
+            if (thrd_create(&threads[started], archiveWorker, outputs[started]) != thrd_success)
+                break;
+    }
+    else
+    {
+        threadCount = i;
+    }
+
+    for (i = 0; i < started; i++)
+        thrd_join(threads[i], NULL);
+    // Serial, or no thread could be started: print as we go on this one.
+    if (started == 0)
+        archiveWorker(NULL);
+
+    fflush(outputFile());
+    for (i = 0; i < count; i++)
+    {
+        if (started > 0)
+            copyOutput(entryStates[i].output, i, count);
+        if (entryStates[i].failed)
+            status = -1;
+    }
+    for (i = 0; i < threadCount; i++)
+    {
+        fclose(outputs[i]);
+        memFree(buffers[i]);
+    }
+
+    memFree(entryStates);
+    entryStates = NULL;
+    scanArchive = NULL;
+    return status;
+}
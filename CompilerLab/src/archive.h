@@ -0,0 +1,42 @@
+/*
+ * @copyright (c) 2026, agent
+ * @author agent
+ * @version 1.0
+ */
+
+#ifndef __ARCHIVE_H__
+#define __ARCHIVE_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define ARCHIVE_THREADS 4
+// Entry contents start on this boundary within the archive.
+#define ARCHIVE_ALIGN 64
+
+typedef struct Archive Archive;
+
+// Called on the scanning thread after each entry, with its output still
+// redirected there; status is as returned by scanBuffer.
+typedef void (*ArchiveEntryDone)(int index, int status);
+
+// Pack fileNames into one archive file. Fails if any file can't be read.
+int archivePack(char *archiveName, char **fileNames, int count);
+
+// Map an archive for scanning. Returns NULL if it is missing or invalid.
+Archive *archiveOpen(const char *archiveName);
+void archiveClose(Archive *archive);
+int archiveEntryCount(Archive *archive);
+const char *archiveEntryName(Archive *archive, int index);
+const unsigned char *archiveEntryData(Archive *archive, int index, size_t *len);
+uint64_t archiveEntryHash(Archive *archive, int index);
+// FNV-1a hash of an entry's contents, as stored in the archive.
+uint64_t archiveHash(const unsigned char *data, size_t len);
+
+// Lex every entry straight from the mapping on threadCount threads. The
+// output of each entry, its diagnostics included, is printed in archive
+// order under its original file name. A lexical error or a content hash
+// mismatch stops that entry only. Returns -1 if any entry failed.
+int archiveScan(Archive *archive, int threadCount, ArchiveEntryDone entryDone);
+
+#endif
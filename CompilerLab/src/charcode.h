@@ -7,6 +7,10 @@
 #ifndef __CHARCODE_H__
 #define __CHARCODE_H__
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 typedef enum
 {
     CHAR_SPACE,
@@ -31,4 +35,8 @@ typedef enum
     CHAR_UNKNOWN
 } CharCode;
 
+#ifdef __cplusplus
+}
+#endif
+
 #endif
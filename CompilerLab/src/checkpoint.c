@@ -0,0 +1,250 @@
+/*
+ * @copyright (c) 2026, agent
+ * @author agent
+ * @version 1.0
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <limits.h>
+#include <sys/stat.h>
+
+#include "reader.h"
+#include "token.h"
+#include "trace.h"
+#include "memtrack.h"
+#include "platform.h"
+#include "scanner.h"
+#include "checkpoint.h"
+
+#define CHECKPOINT_MAGIC "KPLCKP1"
+#define CHECKPOINT_VERSION 1
+
+/// <summary>
+/// Sidecar layout: this header, then count Checkpoints in offset order.
+/// </summary>
+typedef struct
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t count;
+    int64_t fileSize;
+    int64_t mtime;
+    int64_t interval;
+} CheckpointHeader;
+
+static THREAD_LOCAL Checkpoint *checkpoints;
+static THREAD_LOCAL size_t checkpointCount, checkpointCapacity;
+static THREAD_LOCAL long long checkpointInterval;
+static THREAD_LOCAL int checkpointFailed;
+
+/// <summary>
+/// CheckpointSink while recording.
+/// </summary>
+static void recordCheckpoint(LexState lexState)
+{
+    Checkpoint *grown;
+
+    if (checkpointCount == checkpointCapacity)
+    {
+        size_t capacity = checkpointCapacity > 0 ? checkpointCapacity * 2 : 256;
+        grown = (Checkpoint *)memRealloc(MEM_INDEX, checkpoints, capacity * sizeof(Checkpoint));
+        if (grown == NULL)
+        {
+            checkpointFailed = 1;
+            nextCheckpoint = LLONG_MAX;
+            return;
+        }
+        checkpoints = grown;
+        checkpointCapacity = capacity;
+    }
+
+    checkpoints[checkpointCount].offset = inputOffset();
+    checkpoints[checkpointCount].lineNo = lineNo;
+    checkpoints[checkpointCount].colNo = colNo;
+    checkpoints[checkpointCount].lexState = lexState;
+    checkpoints[checkpointCount].reserved = 0;
+    nextCheckpoint = checkpoints[checkpointCount].offset + checkpointInterval;
+    checkpointCount++;
+}
+
+static int fileStamp(char *fileName, long long *size, long long *mtime)
+{
+    struct stat st;
+
+    if (stat(fileName, &st) != 0)
+        return IO_ERROR;
+    *size = (long long)st.st_size;
+#ifdef __linux__
+    *mtime = (long long)st.st_mtim.tv_sec * 1000000000LL + st.st_mtim.tv_nsec;
+#else
+    *mtime = (long long)st.st_mtime;
+#endif
+    return IO_SUCCESS;
+}
+
+void checkpointStart(long long interval)
+{
+    checkpointCount = 0;
+    checkpointFailed = 0;
+    checkpointInterval = interval > 0 ? interval : CHECKPOINT_INTERVAL;
+    checkpointSink = recordCheckpoint;
+    // The start of the input is the first checkpoint.
+    nextCheckpoint = 0;
+}
+
+int checkpointSave(char *fileName, char *sidecarName)
+{
+    CheckpointHeader header;
+    long long size, mtime;
+    FILE *f;
+    int status = IO_SUCCESS;
+
+    checkpointSink = NULL;
+    nextCheckpoint = LLONG_MAX;
+    if (checkpointFailed || fileStamp(fileName, &size, &mtime) == IO_ERROR)
+        status = IO_ERROR;
+
+    f = NULL;
+    if (status == IO_SUCCESS)
+    {
+#ifdef _MSC_VER
+        fopen_s(&f, sidecarName, "wb");
+#else
+        f = fopen(sidecarName, "wb");
+#endif
+    }
+    if (f == NULL)
+        status = IO_ERROR;
+    else
+    {
+        memset(&header, 0, sizeof(header));
+        memcpy(header.magic, CHECKPOINT_MAGIC, sizeof(header.magic));
+        header.version = CHECKPOINT_VERSION;
+        header.count = (uint32_t)checkpointCount;
+        header.fileSize = size;
+        header.mtime = mtime;
+        header.interval = checkpointInterval;
+        if (fwrite(&header, sizeof(header), 1, f) != 1 ||
+            fwrite(checkpoints, sizeof(Checkpoint), checkpointCount, f) != checkpointCount)
+            status = IO_ERROR;
+        if (fclose(f) != 0)
+            status = IO_ERROR;
+    }
+
+    memFree(checkpoints);
+    checkpoints = NULL;
+    checkpointCount = checkpointCapacity = 0;
+    return status;
+}
+
+/***************************************************************/
+
+static int readCheckpoint(FILE *f, uint32_t index, Checkpoint *checkpoint)
+{
+    if (fseek(f, (long)(sizeof(CheckpointHeader) + (size_t)index * sizeof(Checkpoint)), SEEK_SET) != 0)
+        return IO_ERROR;
+    return fread(checkpoint, sizeof(Checkpoint), 1, f) == 1 ? IO_SUCCESS : IO_ERROR;
+}
+
+int checkpointFind(char *fileName, char *sidecarName, long long offset, int lineNo, Checkpoint *found)
+{
+    CheckpointHeader header;
+    Checkpoint checkpoint;
+    long long size, mtime;
+    uint32_t low, high, mid;
+    int before;
+    FILE *f;
+
+    if (sidecarName == NULL || fileStamp(fileName, &size, &mtime) == IO_ERROR)
+        return IO_ERROR;
+#ifdef _MSC_VER
+    fopen_s(&f, sidecarName, "rb");
+#else
+    f = fopen(sidecarName, "rb");
+#endif
+    if (f == NULL)
+        return IO_ERROR;
+
+    if (fread(&header, sizeof(header), 1, f) != 1 || memcmp(header.magic, CHECKPOINT_MAGIC, sizeof(header.magic)) != 0 ||
+        header.version != CHECKPOINT_VERSION || header.fileSize != size || header.mtime != mtime || header.count == 0)
+    {
+        fclose(f);
+        return IO_ERROR;
+    }
+
+    // Binary search for the last checkpoint before the target. For a line,
+    // stop short of it so that tokens earlier on that line are not missed.
+    low = 0;
+    high = header.count;
+    while (high - low > 1)
+    {
+        mid = low + (high - low) / 2;
+        if (readCheckpoint(f, mid, &checkpoint) == IO_ERROR)
+        {
+            fclose(f);
+            return IO_ERROR;
+        }
+        before = offset >= 0 ? checkpoint.offset <= offset : checkpoint.lineNo < lineNo;
+        if (before)
+            low = mid;
+        else
+            high = mid;
+    }
+
+    if (readCheckpoint(f, low, found) == IO_ERROR || found->offset < 0 || found->offset >= size ||
+        found->lexState < LEX_CODE || found->lexState > LEX_LINE_COMMENT ||
+        (found->offset > 0 && (offset >= 0 ? found->offset > offset : found->lineNo >= lineNo)))
+    {
+        fclose(f);
+        return IO_ERROR;
+    }
+    fclose(f);
+    return IO_SUCCESS;
+}
+
+int openInputNear(char *fileName, char *sidecarName, long long offset, int lineNo)
+{
+    Checkpoint checkpoint;
+
+    if (checkpointFind(fileName, sidecarName, offset, lineNo, &checkpoint) == IO_SUCCESS &&
+        openInputStreamAt(fileName, checkpoint.offset, checkpoint.lineNo, checkpoint.colNo) == IO_SUCCESS)
+    {
+        resumeScanner((LexState)checkpoint.lexState);
+        return IO_SUCCESS;
+    }
+
+    // No usable sidecar: lex from the start.
+    if (openInputStream(fileName) == IO_ERROR)
+        return IO_ERROR;
+    initScanner();
+    return IO_SUCCESS;
+}
+
+int scanLines(char *fileName, char *sidecarName, int fromLine, int toLine)
+{
+    Token token;
+
+    TRACE_BEGIN(fileStart);
+    if (openInputNear(fileName, sidecarName, -1, fromLine) == IO_ERROR)
+        return IO_ERROR;
+
+    TRACE_BEGIN(lexStart);
+    while (1)
+    {
+        getTokenInto(&token);
+        if (token.tokenType == TK_EOF || (toLine > 0 && token.lineNo > toLine))
+            break;
+        if (token.lineNo >= fromLine)
+            tokenSink(&token);
+    }
+    TRACE_END(lexStart, "lex", fileName);
+
+    flushOutput(fileName);
+    closeInputStream();
+
+    TRACE_END(fileStart, "file", fileName);
+    return IO_SUCCESS;
+}
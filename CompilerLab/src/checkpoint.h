@@ -0,0 +1,42 @@
+/*
+ * @copyright (c) 2026, agent
+ * @author agent
+ * @version 1.0
+ */
+
+#ifndef __CHECKPOINT_H__
+#define __CHECKPOINT_H__
+
+#include "scanner.h"
+
+#define CHECKPOINT_INTERVAL 65536
+
+/// <summary>
+/// Where the lexer stood at byte offset of the input: the reader's line and
+/// column after reading that byte, and whether it was inside a comment.
+/// </summary>
+typedef struct
+{
+    long long offset;
+    int lineNo, colNo;
+    int lexState;
+    int reserved;
+} Checkpoint;
+
+// Record a checkpoint about every interval bytes while this thread scans
+// its next input.
+void checkpointStart(long long interval);
+// Stop recording and write the checkpoints of fileName to sidecarName,
+// stamped with the file's size and modification time.
+int checkpointSave(char *fileName, char *sidecarName);
+
+// Find the last checkpoint at or before offset, or before line lineNo when
+// offset is negative. Fails if the sidecar does not match fileName.
+int checkpointFind(char *fileName, char *sidecarName, long long offset, int lineNo, Checkpoint *found);
+// Open fileName for getTokenInto at the checkpoint nearest before offset or
+// lineNo, or at the start when no usable sidecar exists.
+int openInputNear(char *fileName, char *sidecarName, long long offset, int lineNo);
+// Pass the tokens of lines fromLine to toLine (0 for the end) to tokenSink.
+int scanLines(char *fileName, char *sidecarName, int fromLine, int toLine);
+
+#endif
@@ -0,0 +1,747 @@
+/* Scanner command line
+ * @copyright (c) 2026, agent
+ * @author agent
+ * @version 1.0
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+#include <setjmp.h>
+#include <stdatomic.h>
+
+#include "reader.h"
+#include "token.h"
+#include "error.h"
+#include "trace.h"
+#include "memtrack.h"
+#include "scanner.h"
+#include "pipeline.h"
+#include "loader.h"
+#include "tokenring.h"
+#include "index.h"
+#include "checkpoint.h"
+#include "archive.h"
+#include "analytics.h"
+#include "driver.h"
+
+static TokenRing* outputRing = NULL;
+// Set once the ring's consumer has gone away. The sink may run on the
+// pipeline's writer thread, so the run reports it when the ring is closed.
+static atomic_int consumerGone;
+static TokenRecord discardedRecord;
+
+/// <summary>
+/// Reserve the next ring record. Once the consumer is gone, records are
+/// written to a scratch one and dropped.
+/// </summary>
+static TokenRecord* reserveRecord(void)
+{
+    TokenRecord* record;
+
+    if (atomic_load(&consumerGone))
+        return &discardedRecord;
+    record = tokenRingReserve(outputRing);
+    if (record == NULL)
+    {
+        atomic_store(&consumerGone, 1);
+        return &discardedRecord;
+    }
+    return record;
+}
+
+static void commitRecord(TokenRecord* record)
+{
+    if (record != &discardedRecord)
+        tokenRingCommit(outputRing);
+}
+
+static void writeRecord(RecordKind kind, int value, int lineNo, int colNo)
+{
+    TokenRecord* record = reserveRecord();
+    record->kind = kind;
+    record->tokenType = TK_NONE;
+    record->lineNo = lineNo;
+    record->colNo = colNo;
+    record->value = value;
+    record->length = 0;
+    record->string[0] = '\0';
+    commitRecord(record);
+}
+
+/// <summary>
+/// TokenSink for -shm: write the token straight into the shared ring.
+/// </summary>
+static void writeTokenRecord(Token* token)
+{
+    TokenRecord* record = reserveRecord();
+    record->kind = RECORD_TOKEN;
+    record->tokenType = token->tokenType;
+    record->lineNo = token->lineNo;
+    record->colNo = token->colNo;
+    record->value = token->value;
+    record->length = token->length;
+    tokenText(token, record->string, sizeof(record->string));
+    commitRecord(record);
+}
+
+static int openOutputRing(char* ringName)
+{
+    outputRing = tokenRingCreate(ringName);
+    if (outputRing == NULL)
+        return IO_ERROR;
+
+    atomic_store(&consumerGone, 0);
+    tokenSink = writeTokenRecord;
+    return IO_SUCCESS;
+}
+
+/// <summary>
+/// End the ring's stream and close it. Returns -1 if the consumer went away
+/// before it had everything.
+/// </summary>
+static int closeOutputRing(void)
+{
+    int status = 0;
+
+    if (outputRing == NULL)
+        return 0;
+
+    writeRecord(RECORD_END, 0, 0, 0);
+    if (atomic_load(&consumerGone))
+    {
+        fprintf(outputFile(), "Token ring consumer is gone!\n");
+        status = -1;
+    }
+    tokenRingClose(outputRing);
+    outputRing = NULL;
+    return status;
+}
+
+// Token types selected with -only, and whether -count was given.
+static TokenMask selectedTokens = ALL_TOKENS;
+static int countOnly = 0;
+// Whether -trace and -memstats were given.
+static int tracing = 0;
+static int memstats = 0;
+static int stdoutBuffered = 0;
+
+// The batch being preloaded: its size, the file being scanned and, while
+// it is held, that file's loaded data.
+static int preloadCount = 0;
+static int preloadIndex = 0;
+static LoadedFile* preloadFile = NULL;
+
+// Where a lexical error ends the run, as error() would end the process.
+static jmp_buf abortJump;
+
+/// <summary>
+/// Parse a comma-separated list of token type names for -only. A name ending
+/// in '_' selects every type with that prefix, e.g. KW_ or SB_.
+/// </summary>
+static int parseTokenList(char* list, TokenMask* mask)
+{
+    char* name = list;
+    size_t len;
+    int type, matched;
+
+    *mask = 0;
+    while (*name != '\0')
+    {
+        len = strcspn(name, ",");
+        matched = 0;
+        for (type = 0; type < TOKEN_TYPE_COUNT; type++)
+        {
+            const char* typeName = tokenTypeName((TokenType)type);
+            if (len > 0 && strncmp(typeName, name, len) == 0 &&
+                (typeName[len] == '\0' || name[len - 1] == '_'))
+            {
+                *mask |= TOKEN_BIT(type);
+                matched = 1;
+            }
+        }
+        if (!matched)
+            return IO_ERROR;
+        name += len;
+        if (*name == ',')
+            name++;
+    }
+    return IO_SUCCESS;
+}
+
+/// <summary>
+/// Print the per-type totals of the file just scanned, for -count.
+/// </summary>
+static void printCounts(void)
+{
+    int type;
+
+    for (type = 0; type < TOKEN_TYPE_COUNT; type++)
+        if ((selectedTokens & TOKEN_BIT(type)) && tokenCounts[type] > 0)
+            fprintf(outputFile(), "%s %lld\n", tokenTypeName((TokenType)type), tokenCounts[type]);
+}
+
+/// <summary>
+/// ArchiveEntryDone for -archive: add the totals to the entry's output.
+/// </summary>
+static void endEntry(int index, int status)
+{
+    if (countOnly)
+        printCounts();
+}
+
+/// <summary>
+/// Mark where each file's tokens start when scanning a batch.
+/// </summary>
+static void beginFile(char* fileName, int index, int fileCount)
+{
+    if (outputRing != NULL)
+        writeRecord(RECORD_FILE, index, 0, 0);
+    else if (fileCount > 1)
+        fprintf(outputFile(), "==> %s <==\n", fileName);
+}
+
+/// <summary>
+/// Report a file that failed or was cut short. Returns the exit status.
+/// </summary>
+static int endFile(int index, int result)
+{
+    if (result == IO_ERROR)
+    {
+        if (outputRing != NULL)
+            writeRecord(RECORD_IOERROR, index, 0, 0);
+        fprintf(outputFile(), "Can\'t read input file!\n");
+        return -1;
+    }
+    if (countOnly)
+        printCounts();
+    if (result == SCAN_BUDGET_EXCEEDED)
+    {
+        if (outputRing != NULL)
+            writeRecord(RECORD_ERROR, ERR_BUDGETEXCEEDED, lineNo, colNo);
+        printError(ERR_BUDGETEXCEEDED, lineNo, colNo);
+        return -1;
+    }
+    return 0;
+}
+
+/// <summary>
+/// Answer -query: print every use of each name from the mapped index.
+/// </summary>
+static int queryIndex(char* indexName, char* names[], int nameCount)
+{
+    IdentIndex* index = indexOpen(indexName);
+    Posting* postings = NULL;
+    long long start;
+    int i, k, count;
+
+    if (index == NULL)
+    {
+        fprintf(outputFile(), "Can\'t open index %s!\n", indexName);
+        return -1;
+    }
+
+    for (i = 0; i < nameCount; i++)
+    {
+        start = traceNow();
+        count = indexLookup(index, names[i], NULL, 0);
+        memFree(postings);
+        postings = (Posting*)memAlloc(MEM_INDEX, (count + 1) * sizeof(Posting));
+        if (postings == NULL)
+            break;
+        count = indexLookup(index, names[i], postings, count);
+
+        fprintf(outputFile(), "==> %s: %d postings, %lld us <==\n", names[i], count, traceNow() - start);
+        for (k = 0; k < count; k++)
+            fprintf(outputFile(), "%s:%d-%d\n", indexFileName(index, postings[k].fileIndex), postings[k].lineNo, postings[k].colNo);
+    }
+
+    memFree(postings);
+    indexClose(index);
+    return 0;
+}
+
+/// <summary>
+/// Build or update the index with -index and report what was done.
+/// </summary>
+static int buildIndex(char* indexName, char* fileNames[], int fileCount, int threadCount)
+{
+    IndexStats stats;
+
+    if (indexBuild(indexName, fileNames, fileCount, threadCount, &stats) == IO_ERROR)
+    {
+        fprintf(outputFile(), "Can\'t write index %s!\n", indexName);
+        return -1;
+    }
+    fprintf(outputFile(), "%s: %d files lexed, %d reused, %lld identifiers, %lld postings, %lld bytes\n",
+           indexName, stats.scanned, stats.reused, stats.terms, stats.postings, stats.bytes);
+    return stats.failed > 0 ? -1 : 0;
+}
+
+/// <summary>
+/// Scan every file packed into an archive with -archive.
+/// </summary>
+static int scanArchiveFile(char* archiveName, int threadCount)
+{
+    Archive* archive = archiveOpen(archiveName);
+    int status;
+
+    if (archive == NULL)
+    {
+        fprintf(outputFile(), "Can\'t open archive %s!\n", archiveName);
+        return -1;
+    }
+    status = archiveScan(archive, threadCount, endEntry);
+    archiveClose(archive);
+    return status;
+}
+
+/// <summary>
+/// Print lexical metrics of a corpus as JSON with -stats, from files or an
+/// archive.
+/// </summary>
+static int printStats(char* fileNames[], int fileCount, char* archiveName, int threadCount, int top)
+{
+    Archive* archive = NULL;
+    int failed = 0;
+    int status;
+
+    if (archiveName != NULL && (archive = archiveOpen(archiveName)) == NULL)
+    {
+        fprintf(outputFile(), "Can\'t open archive %s!\n", archiveName);
+        return -1;
+    }
+    status = analyzeCorpus(fileNames, fileCount, archive, threadCount, top, outputFile(), &failed);
+    archiveClose(archive);
+    if (status == IO_ERROR)
+    {
+        fprintf(outputFile(), "Can\'t analyze corpus!\n");
+        return -1;
+    }
+    return failed > 0 ? -1 : 0;
+}
+
+/******************************************************************/
+
+static void printUsage(void)
+{
+    fprintf(outputFile(), "usage: scanner [-trace TRACE_FILE] [-shm RING_NAME] [-max-ident N] [-max-number N]\n"
+           "               [-max-bytes N] [-max-tokens N] [-max-time MS] [-memstats]\n"
+           "               [-only TYPE,...] [-count] [-no-positions] [-exact-keywords]\n"
+           "               [-pipeline | -preload | -preload-pread] INPUT_FILE...\n"
+           "       scanner -save-checkpoints SIDECAR [-every KB] INPUT_FILE\n"
+           "       scanner -lines FROM[:TO] [-use-checkpoints SIDECAR] INPUT_FILE\n"
+           "       scanner -archive ARCHIVE_FILE [-j THREADS]\n"
+           "       scanner -stats [-j THREADS] [-top N] (-archive ARCHIVE_FILE | INPUT_FILE...)\n"
+           "       scanner -index INDEX_FILE [-j THREADS] [INPUT_FILE...]\n"
+           "       scanner -query INDEX_FILE IDENTIFIER...\n");
+}
+
+/// <summary>
+/// Print the memory report for -memstats at the end of a run.
+/// </summary>
+static void reportMemory(void)
+{
+    fflush(outputFile());
+    memPrintReport(stderr);
+}
+
+/// <summary>
+/// Scan a batch with files loaded ahead by the background loader.
+/// </summary>
+static int scanPreloaded(char* fileNames[], int fileCount)
+{
+    int i;
+    int status = 0;
+
+    preloadCount = fileCount;
+    for (preloadIndex = 0; preloadIndex < fileCount; preloadIndex++)
+    {
+        i = preloadIndex;
+        beginFile(fileNames[i], i, fileCount);
+
+        preloadFile = loaderWait(i);
+        if (preloadFile->status == IO_ERROR)
+        {
+            if (endFile(i, IO_ERROR) != 0)
+                status = -1;
+        }
+        else if (endFile(i, scanBuffer(preloadFile->fileName, preloadFile->data, preloadFile->len)) != 0)
+        {
+            status = -1;
+        }
+        loaderRelease(preloadFile);
+        preloadFile = NULL;
+    }
+
+    loaderStop();
+    preloadCount = 0;
+    return status;
+}
+
+/// <summary>
+/// Let the loader finish a batch that an error cut short, then stop it.
+/// </summary>
+static void abandonPreload(void)
+{
+    if (preloadFile != NULL)
+        loaderRelease(preloadFile);
+    preloadFile = NULL;
+    while (++preloadIndex < preloadCount)
+        loaderRelease(loaderWait(preloadIndex));
+
+    loaderStop();
+    preloadCount = 0;
+}
+
+/// <summary>
+/// errorHook for a run: report the error as error() would, then end the run
+/// rather than the process.
+/// </summary>
+static void abortScan(ErrorCode err, int lineNo, int colNo)
+{
+    if (outputRing != NULL)
+        writeRecord(RECORD_ERROR, err, lineNo, colNo);
+    printError(err, lineNo, colNo);
+    longjmp(abortJump, 1);
+}
+
+/// <summary>
+/// Put every option back to its default, before and after each run.
+/// </summary>
+static void resetOptions(void)
+{
+    maxIdentLen = MAX_IDENT_LEN;
+    maxNumLen = MAX_NUM_LEN;
+    maxFileBytes = 0;
+    maxFileTokens = 0;
+    maxFileMillis = 0;
+    scanOptions = SCAN_DEFAULT;
+    tokenFilter = ALL_TOKENS;
+    countTokens = 0;
+    tokenSink = printToken;
+    checkpointSink = NULL;
+    nextCheckpoint = LLONG_MAX;
+    selectedTokens = ALL_TOKENS;
+    countOnly = 0;
+    tracing = 0;
+    memstats = 0;
+}
+
+static int runCommand(int argc, char* argv[])
+{
+    int i;
+    int fileCount = 0;
+    int status = 0;
+    int pipelined = 0;
+    int preload = 0;
+    LoaderBackend backend = LOADER_BACKEND_AUTO;
+    char* ringName = NULL;
+    char* indexName = NULL;
+    char* queryName = NULL;
+    char* archiveName = NULL;
+    int threadCount = 0;
+    int stats = 0;
+    int top = ANALYTICS_TOP;
+    char* saveCheckpoints = NULL;
+    char* useCheckpoints = NULL;
+    long long checkpointEvery = CHECKPOINT_INTERVAL;
+    int fromLine = 0, toLine = 0;
+
+    for (i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "-trace") == 0)
+        {
+            if (++i == argc)
+            {
+                printUsage();
+                return -1;
+            }
+            if (traceStart(argv[i]) == TRACE_ERROR)
+            {
+                fprintf(outputFile(), "Can\'t start tracing!\n");
+                return -1;
+            }
+            tracing = 1;
+        }
+        else if (strcmp(argv[i], "-shm") == 0)
+        {
+            if (++i == argc)
+            {
+                printUsage();
+                return -1;
+            }
+            ringName = argv[i];
+        }
+        else if (strcmp(argv[i], "-max-ident") == 0 || strcmp(argv[i], "-max-number") == 0)
+        {
+            if (i + 1 == argc || atoi(argv[i + 1]) <= 0)
+            {
+                printUsage();
+                return -1;
+            }
+            if (strcmp(argv[i], "-max-ident") == 0)
+                maxIdentLen = atoi(argv[++i]);
+            else
+                maxNumLen = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "-max-bytes") == 0 || strcmp(argv[i], "-max-tokens") == 0 || strcmp(argv[i], "-max-time") == 0)
+        {
+            if (i + 1 == argc || atoll(argv[i + 1]) <= 0)
+            {
+                printUsage();
+                return -1;
+            }
+            if (strcmp(argv[i], "-max-bytes") == 0)
+                maxFileBytes = atoll(argv[++i]);
+            else if (strcmp(argv[i], "-max-tokens") == 0)
+                maxFileTokens = atoll(argv[++i]);
+            else
+                maxFileMillis = atoll(argv[++i]);
+        }
+        else if (strcmp(argv[i], "-index") == 0 || strcmp(argv[i], "-query") == 0 || strcmp(argv[i], "-archive") == 0)
+        {
+            if (++i == argc)
+            {
+                printUsage();
+                return -1;
+            }
+            if (strcmp(argv[i - 1], "-index") == 0)
+                indexName = argv[i];
+            else if (strcmp(argv[i - 1], "-query") == 0)
+                queryName = argv[i];
+            else
+                archiveName = argv[i];
+        }
+        else if (strcmp(argv[i], "-j") == 0 || strcmp(argv[i], "-top") == 0)
+        {
+            if (i + 1 == argc || atoi(argv[i + 1]) <= 0)
+            {
+                printUsage();
+                return -1;
+            }
+            if (strcmp(argv[i], "-j") == 0)
+                threadCount = atoi(argv[++i]);
+            else
+                top = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "-stats") == 0)
+        {
+            stats = 1;
+        }
+        else if (strcmp(argv[i], "-memstats") == 0)
+        {
+            memstats = 1;
+        }
+        else if (strcmp(argv[i], "-save-checkpoints") == 0 || strcmp(argv[i], "-use-checkpoints") == 0)
+        {
+            if (++i == argc)
+            {
+                printUsage();
+                return -1;
+            }
+            if (strcmp(argv[i - 1], "-save-checkpoints") == 0)
+                saveCheckpoints = argv[i];
+            else
+                useCheckpoints = argv[i];
+        }
+        else if (strcmp(argv[i], "-every") == 0)
+        {
+            if (i + 1 == argc || atoll(argv[i + 1]) <= 0)
+            {
+                printUsage();
+                return -1;
+            }
+            checkpointEvery = atoll(argv[++i]) * 1024;
+        }
+        else if (strcmp(argv[i], "-lines") == 0)
+        {
+            char* to;
+
+            if (i + 1 == argc || (fromLine = atoi(argv[i + 1])) <= 0)
+            {
+                printUsage();
+                return -1;
+            }
+            to = strchr(argv[++i], ':');
+            toLine = to != NULL ? atoi(to + 1) : 0;
+        }
+        else if (strcmp(argv[i], "-only") == 0)
+        {
+            if (i + 1 == argc || parseTokenList(argv[i + 1], &selectedTokens) == IO_ERROR)
+            {
+                printUsage();
+                return -1;
+            }
+            i++;
+        }
+        else if (strcmp(argv[i], "-count") == 0)
+        {
+            countOnly = 1;
+        }
+        else if (strcmp(argv[i], "-no-positions") == 0)
+        {
+            scanOptions &= ~SCAN_POSITIONS;
+        }
+        else if (strcmp(argv[i], "-exact-keywords") == 0)
+        {
+            scanOptions &= ~SCAN_FOLD_KEYWORDS;
+        }
+        else if (strcmp(argv[i], "-pipeline") == 0)
+        {
+            pipelined = 1;
+        }
+        else if (strcmp(argv[i], "-preload") == 0)
+        {
+            preload = 1;
+            backend = LOADER_BACKEND_AUTO;
+        }
+        else if (strcmp(argv[i], "-preload-pread") == 0)
+        {
+            preload = 1;
+            backend = LOADER_BACKEND_PREAD;
+        }
+        else
+        {
+            // Move input files to the front of argv.
+            argv[fileCount++] = argv[i];
+        }
+    }
+
+    // A buffer of our own, so that output memory is accounted for too. Only
+    // stdout is ours to rebuffer, and only before anything is written to it.
+    if (memstats && outputFile() == stdout && !stdoutBuffered)
+    {
+        memBufferStream(stdout, BUFSIZ);
+        stdoutBuffered = 1;
+    }
+
+    if (queryName != NULL)
+        return queryIndex(queryName, argv, fileCount);
+    // With no files, -index refreshes the files already indexed.
+    if (indexName != NULL)
+        return buildIndex(indexName, argv, fileCount, threadCount > 0 ? threadCount : INDEX_THREADS);
+
+    if (stats)
+    {
+        if ((archiveName != NULL) == (fileCount > 0))
+        {
+            printUsage();
+            return -1;
+        }
+        return printStats(argv, fileCount, archiveName, threadCount > 0 ? threadCount : ANALYTICS_THREADS, top);
+    }
+
+    // Counting needs no tokens at all, so nothing gets past the lexer.
+    tokenFilter = countOnly ? 0 : selectedTokens;
+    countTokens = countOnly;
+
+    // Entries are lexed on worker threads, which print rather than use a ring.
+    if (archiveName != NULL)
+    {
+        if (fileCount > 0 || ringName != NULL)
+        {
+            printUsage();
+            return -1;
+        }
+        return scanArchiveFile(archiveName, threadCount > 0 ? threadCount : ARCHIVE_THREADS);
+    }
+
+    if (fileCount == 0)
+    {
+        fprintf(outputFile(), "scanner: no input file.\n");
+        return -1;
+    }
+
+    if (ringName != NULL && openOutputRing(ringName) == IO_ERROR)
+    {
+        if (errno == EEXIST)
+            fprintf(outputFile(), "Shared memory ring %s already exists!\n", ringName);
+        else
+            fprintf(outputFile(), "Can\'t create shared memory ring!\n");
+        return -1;
+    }
+
+    // Line ranges and checkpoints are made of positions.
+    if ((fromLine > 0 || saveCheckpoints != NULL) && !(scanOptions & SCAN_POSITIONS))
+    {
+        printUsage();
+        return -1;
+    }
+
+    // Jump into the middle of a single file, from a checkpoint if there is one.
+    if (fromLine > 0)
+    {
+        if (fileCount != 1)
+        {
+            printUsage();
+            return -1;
+        }
+        return endFile(0, scanLines(argv[0], useCheckpoints, fromLine, toLine));
+    }
+
+    if (saveCheckpoints != NULL)
+    {
+        if (fileCount != 1 || preload)
+        {
+            printUsage();
+            return -1;
+        }
+        checkpointStart(checkpointEvery);
+        status = endFile(0, pipelined ? scanPipelined(argv[0]) : scan(argv[0]));
+        if (status == 0 && checkpointSave(argv[0], saveCheckpoints) == IO_ERROR)
+        {
+            fprintf(outputFile(), "Can\'t write checkpoints %s!\n", saveCheckpoints);
+            status = -1;
+        }
+        return status;
+    }
+
+    // Fall back to synchronous reads where background loading is unavailable.
+    if (preload && loaderStart(argv, fileCount, backend) == IO_SUCCESS)
+        return scanPreloaded(argv, fileCount);
+
+    for (i = 0; i < fileCount; i++)
+    {
+        beginFile(argv[i], i, fileCount);
+
+        if (endFile(i, pipelined ? scanPipelined(argv[i]) : scan(argv[i])) != 0)
+            status = -1;
+    }
+
+    return status;
+}
+
+int scannerMain(int argc, char* argv[])
+{
+    void (*savedErrorHook)(ErrorCode err, int lineNo, int colNo) = errorHook;
+    int status;
+
+    resetOptions();
+    errorHook = abortScan;
+    if (setjmp(abortJump) == 0)
+    {
+        status = runCommand(argc, argv);
+    }
+    else
+    {
+        // Close whatever the error left open.
+        if (inputStream != NULL)
+            closeInputStream();
+        if (preloadCount > 0)
+            abandonPreload();
+        status = -1;
+    }
+
+    if (closeOutputRing() != 0)
+        status = -1;
+    if (memstats)
+        reportMemory();
+    if (tracing)
+        traceStop();
+    resetOptions();
+    errorHook = savedErrorHook;
+    return status;
+}
@@ -0,0 +1,26 @@
+/* Scanner command line
+ * @copyright (c) 2026, agent
+ * @author agent
+ * @version 1.0
+ */
+
+#ifndef __DRIVER_H__
+#define __DRIVER_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// <summary>
+/// Carry out a scanner command line, argv[0] being the program name, and
+/// return its exit status. Output goes to outputFile(); a lexical error ends
+/// the run, not the process. Options are process-wide and reset around each
+/// run, so a run must not overlap any other scan. argv is reordered.
+/// </summary>
+int scannerMain(int argc, char *argv[]);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -7,27 +7,45 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include "error.h"
+#include "reader.h"
 
-void error(ErrorCode err, int lineNo, int colNo)
+THREAD_LOCAL void (*errorHook)(ErrorCode err, int lineNo, int colNo) = NULL;
+
+void printError(ErrorCode err, int lineNo, int colNo)
 {
+    FILE *out = outputFile();
+
     switch (err)
     {
     case ERR_ENDOFCOMMENT:
-        printf("%d-%d:%s\n", lineNo, colNo, ERM_ENDOFCOMMENT);
+        fprintf(out, "%d-%d:%s\n", lineNo, colNo, ERM_ENDOFCOMMENT);
         break;
     case ERR_IDENTTOOLONG:
-        printf("%d-%d:%s\n", lineNo, colNo, ERM_IDENTTOOLONG);
+        fprintf(out, "%d-%d:%s\n", lineNo, colNo, ERM_IDENTTOOLONG);
         break;
     case ERR_NUMLITERALTOOLONG:
-        printf("%d-%d:%s\n", lineNo, colNo, ERM_NUMLITERALTOOLONG);
+        fprintf(out, "%d-%d:%s\n", lineNo, colNo, ERM_NUMLITERALTOOLONG);
+        break;
     case ERR_INVALIDCHARCONSTANT:
-        printf("%d-%d:%s\n", lineNo, colNo, ERM_INVALIDCHARCONSTANT);
+        fprintf(out, "%d-%d:%s\n", lineNo, colNo, ERM_INVALIDCHARCONSTANT);
         break;
     case ERR_INVALIDSYMBOL:
-        printf("%d-%d:%s\n", lineNo, colNo, ERM_INVALIDSYMBOL);
+        fprintf(out, "%d-%d:%s\n", lineNo, colNo, ERM_INVALIDSYMBOL);
         break;
     case ERR_INTERNALERROR:
-        printf("%d-%d:%s\n", lineNo, colNo, ERM_INTERNALERROR);
+        fprintf(out, "%d-%d:%s\n", lineNo, colNo, ERM_INTERNALERROR);
+        break;
+    case ERR_BUDGETEXCEEDED:
+        fprintf(out, "%d-%d:%s\n", lineNo, colNo, ERM_BUDGETEXCEEDED);
+        break;
     }
+}
+
+void error(ErrorCode err, int lineNo, int colNo)
+{
+    if (errorHook != NULL)
+        errorHook(err, lineNo, colNo);
+
+    printError(err, lineNo, colNo);
     exit(-1);
 }
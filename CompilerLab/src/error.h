@@ -7,6 +7,12 @@
 #ifndef __ERROR_H__
 #define __ERROR_H__
 
+#include "platform.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 typedef enum
 {
     ERR_ENDOFCOMMENT,
@@ -14,7 +20,8 @@ typedef enum
     ERR_NUMLITERALTOOLONG,
     ERR_INVALIDCHARCONSTANT,
     ERR_INVALIDSYMBOL,
-    ERR_INTERNALERROR
+    ERR_INTERNALERROR,
+    ERR_BUDGETEXCEEDED
 } ErrorCode;
 
 #define ERM_ENDOFCOMMENT "End of comment expected!"
@@ -23,7 +30,18 @@ typedef enum
 #define ERM_INVALIDCHARCONSTANT "Invalid const char!"
 #define ERM_INVALIDSYMBOL "Invalid symbol!"
 #define ERM_INTERNALERROR "Internal error!"
+#define ERM_BUDGETEXCEEDED "Scan budget exceeded!"
 
+// Called by error() before reporting, so that output still in flight is
+// written ahead of the message.
+extern THREAD_LOCAL void (*errorHook)(ErrorCode err, int lineNo, int colNo);
+
+// Report without stopping; error() reports and exits.
+void printError(ErrorCode err, int lineNo, int colNo);
 void error(ErrorCode err, int lineNo, int colNo);
 
+#ifdef __cplusplus
+}
+#endif
+
 #endif
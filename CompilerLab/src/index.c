@@ -0,0 +1,989 @@
+/*
+ * @copyright (c) 2026, agent
+ * @author agent
+ * @version 1.0
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <ctype.h>
+#include <setjmp.h>
+#include <threads.h>
+#include <stdatomic.h>
+#include <sys/stat.h>
+#ifndef _MSC_VER
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#endif
+
+#include "reader.h"
+#include "token.h"
+#include "error.h"
+#include "trace.h"
+#include "memtrack.h"
+#include "platform.h"
+#include "scanner.h"
+#include "index.h"
+
+#define INDEX_MAGIC "KPLIDX1"
+#define INDEX_VERSION 1
+#define INITIAL_TERMS 1024
+#define MAX_THREADS 64
+
+/*
+ * Index file layout, all integers in host byte order:
+ *
+ *   IndexHeader
+ *   IndexFile[fileCount]
+ *   IndexTerm[termCount]     sorted by name, for binary search
+ *   strings                  NUL-terminated file names and terms
+ *   postings                 per term, sorted by (file, line, column), as
+ *                            varints: file delta, line delta (from 0 when the
+ *                            file changes), column
+ */
+
+typedef struct
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t fileCount;
+    uint32_t termCount;
+    uint32_t reserved;
+    uint64_t fileTable;
+    uint64_t termTable;
+    uint64_t strings;
+    uint64_t postings;
+    uint64_t size;
+} IndexHeader;
+
+typedef struct
+{
+    uint32_t name;
+    uint32_t nameLength;
+    int64_t size;
+    int64_t mtime;
+} IndexFile;
+
+typedef struct
+{
+    uint64_t postings;
+    uint32_t name;
+    uint32_t nameLength;
+    uint32_t postingCount;
+    uint32_t postingBytes;
+} IndexTerm;
+
+struct IdentIndex
+{
+    unsigned char *data;
+    size_t size;
+    const IndexHeader *header;
+    const IndexFile *files;
+    const IndexTerm *terms;
+    const char *strings;
+    const unsigned char *postings;
+};
+
+/// <summary>
+/// A growable byte buffer for assembling the index file.
+/// </summary>
+typedef struct
+{
+    unsigned char *data;
+    size_t len, capacity;
+    int failed;
+} Buffer;
+
+typedef struct
+{
+    char *name;
+    int length;
+    Posting *postings;
+    int count, capacity;
+} TermEntry;
+
+/// <summary>
+/// Open-addressing table from folded identifier to its postings.
+/// </summary>
+typedef struct
+{
+    TermEntry *entries;
+    size_t capacity, count;
+    int failed;
+} TermTable;
+
+typedef struct
+{
+    char *name;
+    long long size, mtime;
+    int oldIndex;   // position in the previous index, or -1
+    int present;    // exists and belongs in the new index
+    int rescan;
+    int status;
+    int errorCode;  // ErrorCode that stopped the scan, or -1
+    int errorLineNo, errorColNo;
+} FileState;
+
+static FileState *fileStates;
+static int fileStateCount;
+static atomic_int nextFile;
+
+static THREAD_LOCAL TermTable *currentTable;
+static THREAD_LOCAL int currentFile;
+static THREAD_LOCAL jmp_buf fileJump;
+
+/***************************************************************/
+
+static void bufferReserve(Buffer *buffer, size_t len)
+{
+    unsigned char *data;
+    size_t capacity;
+
+    if (buffer->capacity - buffer->len >= len)
+        return;
+    capacity = buffer->capacity + buffer->capacity / 2 + len + 4096;
+    data = (unsigned char *)memRealloc(MEM_INDEX, buffer->data, capacity);
+    if (data == NULL)
+    {
+        buffer->failed = 1;
+        return;
+    }
+    buffer->data = data;
+    buffer->capacity = capacity;
+}
+
+static void bufferWrite(Buffer *buffer, const void *data, size_t len)
+{
+    bufferReserve(buffer, len);
+    if (buffer->failed)
+        return;
+    memcpy(buffer->data + buffer->len, data, len);
+    buffer->len += len;
+}
+
+static void bufferVarint(Buffer *buffer, unsigned value)
+{
+    unsigned char bytes[5];
+    int n = 0;
+
+    while (value >= 0x80)
+    {
+        bytes[n++] = (unsigned char)(value | 0x80);
+        value >>= 7;
+    }
+    bytes[n++] = (unsigned char)value;
+    bufferWrite(buffer, bytes, n);
+}
+
+/// <summary>
+/// Decode a varint, or return 0 past end so corrupt files stay in bounds.
+/// </summary>
+static unsigned readVarint(const unsigned char **p, const unsigned char *end)
+{
+    unsigned value = 0;
+    int shift = 0;
+
+    while (*p < end && shift < 35)
+    {
+        unsigned char byte = *(*p)++;
+        value |= (unsigned)(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0)
+            break;
+        shift += 7;
+    }
+    return value;
+}
+
+/***************************************************************/
+
+static unsigned hashName(const char *name, int length)
+{
+    unsigned hash = 2166136261u;
+    int i;
+
+    for (i = 0; i < length; i++)
+        hash = (hash ^ (unsigned char)toupper((unsigned char)name[i])) * 16777619u;
+    return hash;
+}
+
+static int nameEq(const char *folded, const char *name, int length)
+{
+    int i;
+
+    for (i = 0; i < length; i++)
+        if (folded[i] != toupper((unsigned char)name[i]))
+            return 0;
+    return 1;
+}
+
+static void growTable(TermTable *table)
+{
+    TermEntry *old = table->entries;
+    size_t oldCapacity = table->capacity;
+    size_t capacity = oldCapacity > 0 ? oldCapacity * 2 : INITIAL_TERMS;
+    size_t i, slot;
+
+    table->entries = (TermEntry *)memCalloc(MEM_INDEX, capacity, sizeof(TermEntry));
+    if (table->entries == NULL)
+    {
+        table->entries = old;
+        table->failed = 1;
+        return;
+    }
+    table->capacity = capacity;
+
+    for (i = 0; i < oldCapacity; i++)
+    {
+        if (old[i].name == NULL)
+            continue;
+        slot = hashName(old[i].name, old[i].length) & (capacity - 1);
+        while (table->entries[slot].name != NULL)
+            slot = (slot + 1) & (capacity - 1);
+        table->entries[slot] = old[i];
+    }
+    memFree(old);
+}
+
+/// <summary>
+/// Find the entry for name, ignoring case, adding it if it is new.
+/// </summary>
+static TermEntry *findTerm(TermTable *table, const char *name, int length)
+{
+    TermEntry *entry;
+    size_t slot;
+    int i;
+
+    if (table->count * 2 >= table->capacity)
+    {
+        growTable(table);
+        if (table->failed)
+            return NULL;
+    }
+
+    slot = hashName(name, length) & (table->capacity - 1);
+    while (1)
+    {
+        entry = &table->entries[slot];
+        if (entry->name == NULL)
+            break;
+        if (entry->length == length && nameEq(entry->name, name, length))
+            return entry;
+        slot = (slot + 1) & (table->capacity - 1);
+    }
+
+    entry->name = (char *)memAlloc(MEM_INDEX, length + 1);
+    if (entry->name == NULL)
+    {
+        table->failed = 1;
+        return NULL;
+    }
+    for (i = 0; i < length; i++)
+        entry->name[i] = (char)toupper((unsigned char)name[i]);
+    entry->name[length] = '\0';
+    entry->length = length;
+    table->count++;
+    return entry;
+}
+
+static void addPosting(TermTable *table, TermEntry *entry, int fileIndex, int lineNo, int colNo)
+{
+    Posting *postings;
+
+    if (entry->count == entry->capacity)
+    {
+        int capacity = entry->capacity > 0 ? entry->capacity * 2 : 4;
+        postings = (Posting *)memRealloc(MEM_INDEX, entry->postings, capacity * sizeof(Posting));
+        if (postings == NULL)
+        {
+            table->failed = 1;
+            return;
+        }
+        entry->postings = postings;
+        entry->capacity = capacity;
+    }
+    entry->postings[entry->count].fileIndex = fileIndex;
+    entry->postings[entry->count].lineNo = lineNo;
+    entry->postings[entry->count].colNo = colNo;
+    entry->count++;
+}
+
+static void freeTable(TermTable *table)
+{
+    size_t i;
+
+    for (i = 0; i < table->capacity; i++)
+    {
+        memFree(table->entries[i].name);
+        memFree(table->entries[i].postings);
+    }
+    memFree(table->entries);
+}
+
+/***************************************************************/
+
+/// <summary>
+/// TokenSink while indexing; tokenFilter lets only identifiers through.
+/// </summary>
+static void indexToken(Token *token)
+{
+    TermEntry *entry = findTerm(currentTable, token->lexeme, token->length);
+
+    if (entry != NULL)
+        addPosting(currentTable, entry, currentFile, token->lineNo, token->colNo);
+}
+
+/// <summary>
+/// errorHook while indexing: note the error and give up on this file only.
+/// </summary>
+static void stopFile(ErrorCode err, int lineNo, int colNo)
+{
+    fileStates[currentFile].errorCode = err;
+    fileStates[currentFile].errorLineNo = lineNo;
+    fileStates[currentFile].errorColNo = colNo;
+    longjmp(fileJump, 1);
+}
+
+static int indexWorker(void *arg)
+{
+    FileState *file;
+    int i;
+
+    currentTable = (TermTable *)arg;
+    tokenSink = indexToken;
+    errorHook = stopFile;
+
+    while ((i = atomic_fetch_add(&nextFile, 1)) < fileStateCount)
+    {
+        file = &fileStates[i];
+        if (!file->rescan)
+            continue;
+
+        currentFile = i;
+        if (openInputStream(file->name) == IO_ERROR)
+        {
+            file->status = IO_ERROR;
+            continue;
+        }
+        if (setjmp(fileJump) == 0)
+            file->status = scanTokens(file->name);
+        closeInputStream();
+    }
+
+    freeInputBuffer();
+    return 0;
+}
+
+/***************************************************************/
+
+static int compareFileNames(const void *a, const void *b)
+{
+    const FileState *x = (const FileState *)a;
+    const FileState *y = (const FileState *)b;
+    int order = strcmp(x->name, y->name);
+
+    // Keep the entry from the old index first among duplicates.
+    if (order == 0)
+        order = (y->oldIndex >= 0) - (x->oldIndex >= 0);
+    return order;
+}
+
+static int compareTerms(const void *a, const void *b)
+{
+    return strcmp((*(TermEntry *const *)a)->name, (*(TermEntry *const *)b)->name);
+}
+
+static int comparePostings(const void *a, const void *b)
+{
+    const Posting *x = (const Posting *)a;
+    const Posting *y = (const Posting *)b;
+
+    if (x->fileIndex != y->fileIndex)
+        return x->fileIndex < y->fileIndex ? -1 : 1;
+    if (x->lineNo != y->lineNo)
+        return x->lineNo < y->lineNo ? -1 : 1;
+    return (x->colNo > y->colNo) - (x->colNo < y->colNo);
+}
+
+static void statFile(FileState *file)
+{
+    struct stat st;
+
+    file->present = stat(file->name, &st) == 0;
+    if (!file->present)
+        return;
+    file->size = (long long)st.st_size;
+#ifdef __linux__
+    file->mtime = (long long)st.st_mtim.tv_sec * 1000000000LL + st.st_mtim.tv_nsec;
+#else
+    file->mtime = (long long)st.st_mtime;
+#endif
+}
+
+/// <summary>
+/// Whether the term's name and postings lie inside their sections.
+/// </summary>
+static int termInBounds(IdentIndex *index, const IndexTerm *term)
+{
+    uint64_t stringsSize = index->header->postings - index->header->strings;
+    uint64_t postingsSize = index->header->size - index->header->postings;
+
+    return (uint64_t)term->name + term->nameLength <= stringsSize && term->postings <= postingsSize &&
+           term->postingBytes <= postingsSize - term->postings;
+}
+
+/// <summary>
+/// Whether every term of the index can be read for reusePostings.
+/// </summary>
+static int termsInBounds(IdentIndex *index)
+{
+    uint32_t i;
+
+    for (i = 0; i < index->header->termCount; i++)
+        if (!termInBounds(index, &index->terms[i]))
+            return 0;
+    return 1;
+}
+
+/// <summary>
+/// Merge the old index and the new arguments into fileStates, sorted by
+/// name, and decide which files need lexing.
+/// </summary>
+static int collectFiles(IdentIndex *old, char **fileNames, int fileCount)
+{
+    int oldCount = old != NULL ? indexFileCount(old) : 0;
+    int i, j;
+
+    fileStates = (FileState *)memCalloc(MEM_INDEX, oldCount + fileCount + 1, sizeof(FileState));
+    if (fileStates == NULL)
+        return IO_ERROR;
+
+    for (i = 0; i < oldCount; i++)
+    {
+        fileStates[i].name = (char *)indexFileName(old, i);
+        fileStates[i].oldIndex = i;
+    }
+    for (i = 0; i < fileCount; i++)
+    {
+        fileStates[oldCount + i].name = fileNames[i];
+        fileStates[oldCount + i].oldIndex = -1;
+    }
+    qsort(fileStates, oldCount + fileCount, sizeof(FileState), compareFileNames);
+
+    fileStateCount = 0;
+    for (i = 0; i < oldCount + fileCount; i++)
+    {
+        if (fileStateCount > 0 && strcmp(fileStates[fileStateCount - 1].name, fileStates[i].name) == 0)
+            continue;
+        fileStates[fileStateCount++] = fileStates[i];
+    }
+
+    for (i = 0; i < fileStateCount; i++)
+    {
+        FileState *file = &fileStates[i];
+
+        j = file->oldIndex;
+        file->errorCode = -1;
+        file->status = IO_SUCCESS;
+        statFile(file);
+        if (!file->present)
+        {
+            // Gone since the last build: drop it quietly.
+            if (j < 0)
+                file->status = IO_ERROR;
+            continue;
+        }
+        file->rescan = j < 0 || old->files[j].size != file->size || old->files[j].mtime != file->mtime;
+    }
+    return IO_SUCCESS;
+}
+
+/// <summary>
+/// Copy the postings of files that did not change out of the old index,
+/// whose terms indexBuild has checked with termsInBounds.
+/// </summary>
+static void reusePostings(IdentIndex *old, TermTable *table)
+{
+    const unsigned char *p, *end;
+    int *newIndex;
+    TermEntry *entry;
+    uint32_t i, k;
+    int fileIndex, lineNo, colNo, delta;
+
+    newIndex = (int *)memAlloc(MEM_INDEX, (old->header->fileCount + 1) * sizeof(int));
+    if (newIndex == NULL)
+    {
+        table->failed = 1;
+        return;
+    }
+    for (i = 0; i < old->header->fileCount; i++)
+        newIndex[i] = -1;
+    for (i = 0; i < (uint32_t)fileStateCount; i++)
+        if (fileStates[i].oldIndex >= 0 && fileStates[i].present && !fileStates[i].rescan)
+            newIndex[fileStates[i].oldIndex] = (int)i;
+
+    for (i = 0; i < old->header->termCount && !table->failed; i++)
+    {
+        const IndexTerm *term = &old->terms[i];
+
+        entry = NULL;
+        p = old->postings + term->postings;
+        end = p + term->postingBytes;
+        fileIndex = lineNo = 0;
+        for (k = 0; k < term->postingCount; k++)
+        {
+            delta = (int)readVarint(&p, end);
+            fileIndex += delta;
+            lineNo = (delta > 0 ? 0 : lineNo) + (int)readVarint(&p, end);
+            colNo = (int)readVarint(&p, end);
+            if (fileIndex >= (int)old->header->fileCount || newIndex[fileIndex] < 0)
+                continue;
+
+            if (entry == NULL && (entry = findTerm(table, old->strings + term->name, (int)term->nameLength)) == NULL)
+                break;
+            addPosting(table, entry, newIndex[fileIndex], lineNo, colNo);
+        }
+    }
+    memFree(newIndex);
+}
+
+/// <summary>
+/// Merge the per-thread tables and write the index file image to out.
+/// </summary>
+static int writeIndex(TermTable *tables, int tableCount, Buffer *out, IndexStats *stats)
+{
+    Buffer fileTable = {0}, termTable = {0}, strings = {0}, postings = {0};
+    IndexHeader header;
+    TermEntry **entries;
+    Posting *merged = NULL;
+    int *outputIndex;
+    size_t entryCount = 0, i, j, k, mergedCapacity = 0;
+    int t, status = IO_SUCCESS;
+
+    outputIndex = (int *)memAlloc(MEM_INDEX, (fileStateCount + 1) * sizeof(int));
+    for (t = 0; t < tableCount; t++)
+        entryCount += tables[t].count;
+    entries = (TermEntry **)memAlloc(MEM_INDEX, (entryCount + 1) * sizeof(TermEntry *));
+    if (outputIndex == NULL || entries == NULL)
+    {
+        memFree(outputIndex);
+        memFree(entries);
+        return IO_ERROR;
+    }
+
+    // Files that could not be read are left out and the rest renumbered.
+    memset(&header, 0, sizeof(header));
+    for (i = 0; i < (size_t)fileStateCount; i++)
+    {
+        IndexFile file;
+
+        outputIndex[i] = -1;
+        if (!fileStates[i].present || fileStates[i].status == IO_ERROR)
+            continue;
+        outputIndex[i] = (int)header.fileCount++;
+        file.name = (uint32_t)strings.len;
+        file.nameLength = (uint32_t)strlen(fileStates[i].name);
+        file.size = fileStates[i].size;
+        file.mtime = fileStates[i].mtime;
+        bufferWrite(&strings, fileStates[i].name, file.nameLength + 1);
+        bufferWrite(&fileTable, &file, sizeof(file));
+    }
+
+    entryCount = 0;
+    for (t = 0; t < tableCount; t++)
+        for (i = 0; i < tables[t].capacity; i++)
+            if (tables[t].entries[i].name != NULL)
+                entries[entryCount++] = &tables[t].entries[i];
+    qsort(entries, entryCount, sizeof(TermEntry *), compareTerms);
+
+    for (i = 0; i < entryCount; i = j)
+    {
+        IndexTerm term;
+        size_t count = 0;
+        int lastFile = 0, lastLine = 0;
+
+        // Gather the postings of one name from every thread.
+        for (j = i; j < entryCount && strcmp(entries[j]->name, entries[i]->name) == 0; j++)
+            count += entries[j]->count;
+        if (count > mergedCapacity)
+        {
+            Posting *grown = (Posting *)memRealloc(MEM_INDEX, merged, count * sizeof(Posting));
+            if (grown == NULL)
+            {
+                status = IO_ERROR;
+                break;
+            }
+            merged = grown;
+            mergedCapacity = count;
+        }
+        count = 0;
+        for (k = i; k < j; k++)
+            for (t = 0; t < entries[k]->count; t++)
+                if (outputIndex[entries[k]->postings[t].fileIndex] >= 0)
+                {
+                    merged[count] = entries[k]->postings[t];
+                    merged[count].fileIndex = outputIndex[merged[count].fileIndex];
+                    count++;
+                }
+        if (count == 0)
+            continue;
+        qsort(merged, count, sizeof(Posting), comparePostings);
+
+        term.postings = postings.len;
+        term.name = (uint32_t)strings.len;
+        term.nameLength = (uint32_t)entries[i]->length;
+        term.postingCount = (uint32_t)count;
+        bufferWrite(&strings, entries[i]->name, entries[i]->length + 1);
+        for (k = 0; k < count; k++)
+        {
+            if (merged[k].fileIndex != lastFile)
+                lastLine = 0;
+            bufferVarint(&postings, (unsigned)(merged[k].fileIndex - lastFile));
+            bufferVarint(&postings, (unsigned)(merged[k].lineNo - lastLine));
+            bufferVarint(&postings, (unsigned)merged[k].colNo);
+            lastFile = merged[k].fileIndex;
+            lastLine = merged[k].lineNo;
+        }
+        term.postingBytes = (uint32_t)(postings.len - term.postings);
+        bufferWrite(&termTable, &term, sizeof(term));
+
+        header.termCount++;
+        stats->postings += (long long)count;
+    }
+    stats->terms = header.termCount;
+
+    memcpy(header.magic, INDEX_MAGIC, sizeof(header.magic));
+    header.version = INDEX_VERSION;
+    header.fileTable = sizeof(header);
+    header.termTable = header.fileTable + fileTable.len;
+    header.strings = header.termTable + termTable.len;
+    header.postings = header.strings + strings.len;
+    header.size = header.postings + postings.len;
+
+    bufferWrite(out, &header, sizeof(header));
+    bufferWrite(out, fileTable.data, fileTable.len);
+    bufferWrite(out, termTable.data, termTable.len);
+    bufferWrite(out, strings.data, strings.len);
+    bufferWrite(out, postings.data, postings.len);
+    if (fileTable.failed || termTable.failed || strings.failed || postings.failed || out->failed)
+        status = IO_ERROR;
+
+    memFree(fileTable.data);
+    memFree(termTable.data);
+    memFree(strings.data);
+    memFree(postings.data);
+    memFree(merged);
+    memFree(entries);
+    memFree(outputIndex);
+    return status;
+}
+
+/// <summary>
+/// Write data to indexName through a temporary file, so that readers never
+/// see a half-written index.
+/// </summary>
+static int replaceFile(char *indexName, Buffer *data)
+{
+    char *tempName = (char *)memAlloc(MEM_INDEX, strlen(indexName) + 5);
+    FILE *f;
+    int status = IO_SUCCESS;
+
+    if (tempName == NULL)
+        return IO_ERROR;
+    sprintf(tempName, "%s.tmp", indexName);
+
+#ifdef _MSC_VER
+    fopen_s(&f, tempName, "wb");
+#else
+    f = fopen(tempName, "wb");
+#endif
+    if (f == NULL)
+    {
+        memFree(tempName);
+        return IO_ERROR;
+    }
+    if (fwrite(data->data, 1, data->len, f) != data->len)
+        status = IO_ERROR;
+    if (fclose(f) != 0)
+        status = IO_ERROR;
+
+#ifdef _MSC_VER
+    // rename does not replace an existing file on Windows.
+    if (status == IO_SUCCESS)
+        remove(indexName);
+#endif
+    if (status == IO_ERROR || rename(tempName, indexName) != 0)
+    {
+        remove(tempName);
+        status = IO_ERROR;
+    }
+    memFree(tempName);
+    return status;
+}
+
+int indexBuild(char *indexName, char **fileNames, int fileCount, int threadCount, IndexStats *stats)
+{
+    thrd_t threads[MAX_THREADS];
+    TermTable tables[MAX_THREADS + 1];
+    IdentIndex *old = indexOpen(indexName);
+    TokenSink savedSink = tokenSink;
+    void (*savedErrorHook)(ErrorCode err, int lineNo, int colNo) = errorHook;
+    TokenMask savedFilter = tokenFilter;
+    int savedOptions = scanOptions;
+    Buffer out = {0};
+    int i, started, status, reusable;
+
+    memset(stats, 0, sizeof(*stats));
+    memset(tables, 0, sizeof(tables));
+    if (threadCount < 1)
+        threadCount = 1;
+    if (threadCount > MAX_THREADS)
+        threadCount = MAX_THREADS;
+
+    if (collectFiles(old, fileNames, fileCount) == IO_ERROR)
+    {
+        indexClose(old);
+        return IO_ERROR;
+    }
+    // Postings that can't be read are nothing to reuse: keep the file list
+    // but lex every file again.
+    reusable = old != NULL && termsInBounds(old);
+    if (!reusable)
+        for (i = 0; i < fileStateCount; i++)
+            fileStates[i].rescan = fileStates[i].present;
+
+    // Only identifiers reach the sink; everything else stays in the lexer.
+    // Postings need positions, and keywords are never indexed as names.
+    tokenFilter = TOKEN_BIT(TK_IDENT);
+    scanOptions = SCAN_DEFAULT;
+    atomic_init(&nextFile, 0);
+    for (started = 0; started < threadCount; started++)
+        if (thrd_create(&threads[started], indexWorker, &tables[started]) != thrd_success)
+            break;
+    for (i = 0; i < started; i++)
+        thrd_join(threads[i], NULL);
+    // No thread could be started: scan on this one.
+    if (started == 0)
+        indexWorker(&tables[started++]);
+    tokenSink = savedSink;
+    errorHook = savedErrorHook;
+    tokenFilter = savedFilter;
+    scanOptions = savedOptions;
+
+    TRACE_BEGIN(mergeStart);
+    if (reusable)
+        reusePostings(old, &tables[started]);
+
+    for (i = 0; i < fileStateCount; i++)
+    {
+        if (fileStates[i].rescan)
+            stats->scanned++;
+        else if (fileStates[i].present)
+            stats->reused++;
+
+        if (fileStates[i].status == IO_ERROR)
+        {
+            fprintf(outputFile(), "%s: Can\'t read input file!\n", fileStates[i].name);
+            stats->failed++;
+        }
+        else if (fileStates[i].errorCode >= 0 || fileStates[i].status == SCAN_BUDGET_EXCEEDED)
+        {
+            // Postings found before the error are kept.
+            fprintf(outputFile(), "%s: ", fileStates[i].name);
+            if (fileStates[i].errorCode >= 0)
+                printError((ErrorCode)fileStates[i].errorCode, fileStates[i].errorLineNo, fileStates[i].errorColNo);
+            else
+                fprintf(outputFile(), "%s\n", ERM_BUDGETEXCEEDED);
+            stats->failed++;
+        }
+    }
+
+    status = IO_SUCCESS;
+    for (i = 0; i <= started; i++)
+        if (tables[i].failed)
+            status = IO_ERROR;
+    if (status == IO_SUCCESS)
+        status = writeIndex(tables, started + 1, &out, stats);
+    TRACE_END(mergeStart, "merge", indexName);
+
+    // Old file names live in the mapping; done with them now.
+    indexClose(old);
+    memFree(fileStates);
+    fileStates = NULL;
+    for (i = 0; i <= started; i++)
+        freeTable(&tables[i]);
+
+    if (status == IO_SUCCESS)
+    {
+        TRACE_BEGIN(writeStart);
+        status = replaceFile(indexName, &out);
+        TRACE_END(writeStart, "write", indexName);
+    }
+    stats->bytes = (long long)out.len;
+    memFree(out.data);
+    return status;
+}
+
+/***************************************************************/
+
+IdentIndex *indexOpen(const char *indexName)
+{
+    IdentIndex *index = (IdentIndex *)memCalloc(MEM_INDEX, 1, sizeof(IdentIndex));
+    const IndexHeader *header;
+    uint32_t i;
+
+    if (index == NULL)
+        return NULL;
+
+#ifdef _MSC_VER
+    {
+        FILE *f;
+        long size;
+
+        fopen_s(&f, indexName, "rb");
+        if (f == NULL || fseek(f, 0, SEEK_END) != 0 || (size = ftell(f)) < 0 || fseek(f, 0, SEEK_SET) != 0)
+        {
+            if (f != NULL)
+                fclose(f);
+            memFree(index);
+            return NULL;
+        }
+        index->size = (size_t)size;
+        index->data = (unsigned char *)memAlloc(MEM_INDEX, index->size + 1);
+        if (index->data == NULL || fread(index->data, 1, index->size, f) != index->size)
+        {
+            fclose(f);
+            memFree(index->data);
+            memFree(index);
+            return NULL;
+        }
+        fclose(f);
+    }
+#else
+    {
+        struct stat st;
+        void *map;
+        int fd = open(indexName, O_RDONLY);
+
+        if (fd < 0 || fstat(fd, &st) != 0 || st.st_size == 0)
+        {
+            if (fd >= 0)
+                close(fd);
+            memFree(index);
+            return NULL;
+        }
+        map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (map == MAP_FAILED)
+        {
+            memFree(index);
+            return NULL;
+        }
+        index->data = (unsigned char *)map;
+        index->size = (size_t)st.st_size;
+    }
+#endif
+
+    header = (const IndexHeader *)index->data;
+    if (index->size < sizeof(IndexHeader) || memcmp(header->magic, INDEX_MAGIC, sizeof(header->magic)) != 0 ||
+        header->version != INDEX_VERSION || header->size != index->size ||
+        header->fileTable + (uint64_t)header->fileCount * sizeof(IndexFile) > header->termTable ||
+        header->termTable + (uint64_t)header->termCount * sizeof(IndexTerm) > header->strings ||
+        header->strings > header->postings || header->postings > header->size)
+    {
+        indexClose(index);
+        return NULL;
+    }
+
+    index->header = header;
+    index->files = (const IndexFile *)(index->data + header->fileTable);
+    index->terms = (const IndexTerm *)(index->data + header->termTable);
+    index->strings = (const char *)(index->data + header->strings);
+    index->postings = index->data + header->postings;
+
+    // Names are used as C strings, so check they stay inside the strings.
+    for (i = 0; i < header->fileCount; i++)
+        if ((uint64_t)index->files[i].name + index->files[i].nameLength >= header->postings - header->strings)
+            break;
+    if (i < header->fileCount)
+    {
+        indexClose(index);
+        return NULL;
+    }
+    return index;
+}
+
+void indexClose(IdentIndex *index)
+{
+    if (index == NULL)
+        return;
+#ifdef _MSC_VER
+    memFree(index->data);
+#else
+    munmap(index->data, index->size);
+#endif
+    memFree(index);
+}
+
+int indexFileCount(IdentIndex *index)
+{
+    return (int)index->header->fileCount;
+}
+
+const char *indexFileName(IdentIndex *index, int fileIndex)
+{
+    return index->strings + index->files[fileIndex].name;
+}
+
+int indexLookup(IdentIndex *index, const char *ident, Posting *postings, int max)
+{
+    const IndexTerm *term;
+    const unsigned char *p, *end;
+    size_t length = strlen(ident);
+    uint32_t low = 0, high = index->header->termCount, mid;
+    int order, k, fileIndex = 0, lineNo = 0, delta;
+
+    // Binary search the sorted terms, comparing with the query folded.
+    while (low < high)
+    {
+        size_t i, n;
+
+        mid = low + (high - low) / 2;
+        term = &index->terms[mid];
+        if (!termInBounds(index, term))
+            return 0;
+
+        n = term->nameLength < length ? term->nameLength : length;
+        order = 0;
+        for (i = 0; i < n && order == 0; i++)
+            order = (unsigned char)index->strings[term->name + i] - toupper((unsigned char)ident[i]);
+        if (order == 0)
+            order = (term->nameLength > length) - (term->nameLength < length);
+
+        if (order == 0)
+            break;
+        if (order < 0)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+    if (low >= high)
+        return 0;
+
+    p = index->postings + term->postings;
+    end = p + term->postingBytes;
+    for (k = 0; k < max && k < (int)term->postingCount; k++)
+    {
+        delta = (int)readVarint(&p, end);
+        fileIndex += delta;
+        if (fileIndex >= (int)index->header->fileCount)
+            return 0;
+        lineNo = (delta > 0 ? 0 : lineNo) + (int)readVarint(&p, end);
+        postings[k].fileIndex = fileIndex;
+        postings[k].lineNo = lineNo;
+        postings[k].colNo = (int)readVarint(&p, end);
+    }
+    return (int)term->postingCount;
+}
@@ -0,0 +1,47 @@
+/*
+ * @copyright (c) 2026, agent
+ * @author agent
+ * @version 1.0
+ */
+
+#ifndef __INDEX_H__
+#define __INDEX_H__
+
+#define INDEX_THREADS 4
+
+/// <summary>
+/// One use of an identifier. fileIndex numbers the files of the index.
+/// </summary>
+typedef struct
+{
+    int fileIndex;
+    int lineNo, colNo;
+} Posting;
+
+typedef struct
+{
+    int scanned;   // files lexed by this build
+    int reused;    // unchanged files whose postings were copied over
+    int failed;    // files that could not be read or stopped on an error
+    long long terms;
+    long long postings;
+    long long bytes;
+} IndexStats;
+
+typedef struct IdentIndex IdentIndex;
+
+// Build or update the index file indexName. It covers fileNames plus every
+// file already in the index; files unchanged since then are not lexed
+// again and deleted ones are dropped. Lexing runs on threadCount threads.
+int indexBuild(char *indexName, char **fileNames, int fileCount, int threadCount, IndexStats *stats);
+
+// Map an index file for queries. Returns NULL if it is missing or invalid.
+IdentIndex *indexOpen(const char *indexName);
+void indexClose(IdentIndex *index);
+int indexFileCount(IdentIndex *index);
+const char *indexFileName(IdentIndex *index, int fileIndex);
+// Number of postings of ident, matched without regard to case, or 0 if it
+// is not indexed. The first max of them are decoded into postings.
+int indexLookup(IdentIndex *index, const char *ident, Posting *postings, int max);
+
+#endif
@@ -0,0 +1,147 @@
+/* Corpus packer for scanner -archive
+ * @copyright (c) 2026, agent
+ * @author agent
+ * @version 1.0
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "reader.h"
+#include "archive.h"
+
+#define MAX_NAME_LEN 4096
+
+void printUsage(void)
+{
+    printf("usage: kplpack ARCHIVE [-l LIST_FILE] [INPUT_FILE...]\n"
+           "       kplpack -t ARCHIVE\n");
+}
+
+/// <summary>
+/// Append the file names listed one per line in listName to *names.
+/// </summary>
+int readList(char* listName, char*** names, int* count, int* capacity)
+{
+    char line[MAX_NAME_LEN];
+    char** grown;
+    size_t len;
+    FILE* f;
+
+#ifdef _MSC_VER
+    fopen_s(&f, listName, "rt");
+#else
+    f = fopen(listName, "rt");
+#endif
+    if (f == NULL)
+        return IO_ERROR;
+
+    while (fgets(line, sizeof(line), f) != NULL)
+    {
+        len = strcspn(line, "\r\n");
+        if (len == 0)
+            continue;
+        line[len] = '\0';
+
+        if (*count == *capacity)
+        {
+            *capacity = *capacity > 0 ? *capacity * 2 : 256;
+            grown = (char**)realloc(*names, *capacity * sizeof(char*));
+            if (grown == NULL)
+            {
+                fclose(f);
+                return IO_ERROR;
+            }
+            *names = grown;
+        }
+        (*names)[*count] = (char*)malloc(len + 1);
+        if ((*names)[*count] == NULL)
+        {
+            fclose(f);
+            return IO_ERROR;
+        }
+        memcpy((*names)[(*count)++], line, len + 1);
+    }
+
+    fclose(f);
+    return IO_SUCCESS;
+}
+
+/// <summary>
+/// Print the table of an archive: length, content hash and name per entry.
+/// </summary>
+int listArchive(char* archiveName)
+{
+    Archive* archive = archiveOpen(archiveName);
+    size_t len;
+    int i;
+
+    if (archive == NULL)
+    {
+        printf("Can\'t open archive %s!\n", archiveName);
+        return -1;
+    }
+
+    for (i = 0; i < archiveEntryCount(archive); i++)
+    {
+        archiveEntryData(archive, i, &len);
+        printf("%10zu %016llx %s\n", len, (unsigned long long)archiveEntryHash(archive, i), archiveEntryName(archive, i));
+    }
+
+    archiveClose(archive);
+    return 0;
+}
+
+int main(int argc, char* argv[])
+{
+    char** names = NULL;
+    char* archiveName = NULL;
+    int count = 0, capacity = 0;
+    int i, status;
+
+    if (argc == 3 && strcmp(argv[1], "-t") == 0)
+        return listArchive(argv[2]);
+
+    for (i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "-l") == 0)
+        {
+            if (++i == argc || readList(argv[i], &names, &count, &capacity) == IO_ERROR)
+            {
+                printf("Can\'t read file list!\n");
+                return -1;
+            }
+        }
+        else if (archiveName == NULL)
+        {
+            archiveName = argv[i];
+        }
+        else
+        {
+            if (count == capacity)
+            {
+                capacity = capacity > 0 ? capacity * 2 : 256;
+                names = (char**)realloc(names, capacity * sizeof(char*));
+                if (names == NULL)
+                    return -1;
+            }
+            names[count++] = argv[i];
+        }
+    }
+
+    if (archiveName == NULL || count == 0)
+    {
+        printUsage();
+        return -1;
+    }
+
+    status = archivePack(archiveName, names, count);
+    if (status == IO_ERROR)
+    {
+        printf("Can\'t write archive %s!\n", archiveName);
+        return -1;
+    }
+    printf("%s: %d files\n", archiveName, count);
+    return 0;
+}
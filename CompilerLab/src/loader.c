@@ -0,0 +1,504 @@
+/*
+ * @copyright (c) 2026, agent
+ * @author agent
+ * @version 1.0
+ */
+
+#include <stdlib.h>
+#include "reader.h"
+#include "loader.h"
+
+#ifdef _WIN32
+
+int loaderStart(char **fileNames, int count, LoaderBackend backend)
+{
+    (void)fileNames;
+    (void)count;
+    (void)backend;
+    return IO_ERROR;
+}
+
+LoadedFile *loaderWait(int index)
+{
+    (void)index;
+    return NULL;
+}
+
+void loaderRelease(LoadedFile *file)
+{
+    (void)file;
+}
+
+void loaderStop(void)
+{
+}
+
+#else
+
+#include <string.h>
+#include <errno.h>
+#include <stdatomic.h>
+#include <threads.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#ifdef __linux__
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+#endif
+
+#include "trace.h"
+#include "memtrack.h"
+
+#define INITIAL_CAPACITY 65536
+
+typedef enum
+{
+    SLOT_FREE,
+    SLOT_LOADING,
+    SLOT_READY
+} SlotState;
+
+/// <summary>
+/// Slot s holds files s, s + LOADER_SLOTS, ... in turn; nextIndex is the
+/// only file allowed to claim it next.
+/// </summary>
+typedef struct
+{
+    LoadedFile file;
+    size_t capacity;
+    SlotState state;
+    int nextIndex;
+    // In-flight read, io_uring backend only.
+    int fd;
+    size_t size;
+} LoadSlot;
+
+static char **loadNames;
+static int loadCount;
+static LoadSlot slots[LOADER_SLOTS];
+static atomic_int nextFile;
+
+static mtx_t loadLock;
+static cnd_t loadChanged;
+
+static thrd_t loadThreads[LOADER_THREADS];
+static int loadThreadCount;
+
+/***************************************************************/
+
+static LoadSlot *claimSlot(int index, int wait)
+{
+    LoadSlot *slot = &slots[index % LOADER_SLOTS];
+
+    mtx_lock(&loadLock);
+    while (slot->state != SLOT_FREE || slot->nextIndex != index)
+    {
+        if (!wait)
+        {
+            mtx_unlock(&loadLock);
+            return NULL;
+        }
+        cnd_wait(&loadChanged, &loadLock);
+    }
+    slot->state = SLOT_LOADING;
+    slot->nextIndex = index + LOADER_SLOTS;
+    mtx_unlock(&loadLock);
+
+    slot->file.fileName = loadNames[index];
+    slot->file.len = 0;
+    slot->file.status = IO_SUCCESS;
+    return slot;
+}
+
+static void publishSlot(LoadSlot *slot)
+{
+    mtx_lock(&loadLock);
+    slot->state = SLOT_READY;
+    cnd_broadcast(&loadChanged);
+    mtx_unlock(&loadLock);
+}
+
+/// <summary>
+/// Open the slot's file and size its buffer. Returns the descriptor, or -1
+/// with the slot marked as failed.
+/// </summary>
+static int openSlot(LoadSlot *slot)
+{
+    struct stat st;
+    unsigned char *data;
+    int fd;
+
+    memBeginFile(slot->file.fileName);
+    TRACE_BEGIN(start);
+    fd = open(slot->file.fileName, O_RDONLY);
+    TRACE_END(start, "open", slot->file.fileName);
+
+    if (fd < 0 || fstat(fd, &st) < 0)
+    {
+        if (fd >= 0)
+            close(fd);
+        slot->file.status = IO_ERROR;
+        return -1;
+    }
+
+    slot->size = (size_t)st.st_size;
+    if (slot->size > slot->capacity)
+    {
+        data = (unsigned char *)memRealloc(MEM_INPUT, slot->file.data, slot->size);
+        if (data == NULL)
+        {
+            close(fd);
+            slot->file.status = IO_ERROR;
+            return -1;
+        }
+        slot->file.data = data;
+        slot->capacity = slot->size;
+    }
+    return fd;
+}
+
+/// <summary>
+/// Read the rest of the slot's file with blocking pread calls.
+/// </summary>
+static void preadSlot(LoadSlot *slot, int fd)
+{
+    ssize_t n;
+
+    TRACE_BEGIN(start);
+    while (slot->file.len < slot->size)
+    {
+        n = pread(fd, slot->file.data + slot->file.len, slot->size - slot->file.len, (off_t)slot->file.len);
+        if (n < 0)
+            slot->file.status = IO_ERROR;
+        if (n <= 0)
+            break;
+        slot->file.len += (size_t)n;
+    }
+    TRACE_END(start, "read", slot->file.fileName);
+}
+
+/***************************************************************/
+
+/// <summary>
+/// Fallback backend: each worker takes the next file and loads it with
+/// blocking pread calls.
+/// </summary>
+static int preadWorker(void *arg)
+{
+    LoadSlot *slot;
+    int index, fd;
+
+    (void)arg;
+    while ((index = atomic_fetch_add(&nextFile, 1)) < loadCount)
+    {
+        slot = claimSlot(index, 1);
+
+        fd = openSlot(slot);
+        if (fd >= 0)
+        {
+            preadSlot(slot, fd);
+            close(fd);
+        }
+
+        publishSlot(slot);
+    }
+    return 0;
+}
+
+#ifdef __linux__
+
+typedef struct
+{
+    int fd;
+    unsigned *sqHead, *sqTail, *sqMask, *sqArray;
+    unsigned *cqHead, *cqTail, *cqMask;
+    struct io_uring_sqe *sqes;
+    struct io_uring_cqe *cqes;
+    void *sqRing, *cqRing;
+    size_t sqRingSize, cqRingSize, sqesSize;
+} Ring;
+
+static Ring ring;
+
+static void ringFree(void)
+{
+    if (ring.sqes != MAP_FAILED)
+        munmap(ring.sqes, ring.sqesSize);
+    if (ring.cqRing != MAP_FAILED)
+        munmap(ring.cqRing, ring.cqRingSize);
+    if (ring.sqRing != MAP_FAILED)
+        munmap(ring.sqRing, ring.sqRingSize);
+    close(ring.fd);
+}
+
+/// <summary>
+/// Ask the kernel whether it knows IORING_OP_READ. Kernels before 5.6 have
+/// io_uring but neither the probe nor the opcode.
+/// </summary>
+static int ringSupportsRead(void)
+{
+    union
+    {
+        struct io_uring_probe probe;
+        unsigned char bytes[sizeof(struct io_uring_probe) + IORING_OP_LAST * sizeof(struct io_uring_probe_op)];
+    } buffer;
+
+    memset(&buffer, 0, sizeof(buffer));
+    if (syscall(__NR_io_uring_register, ring.fd, IORING_REGISTER_PROBE, &buffer.probe, IORING_OP_LAST) < 0)
+        return 0;
+    return buffer.probe.last_op >= IORING_OP_READ &&
+           (buffer.probe.ops[IORING_OP_READ].flags & IO_URING_OP_SUPPORTED) != 0;
+}
+
+static int ringInit(unsigned entries)
+{
+    struct io_uring_params params;
+    unsigned char *sq, *cq;
+
+    memset(&params, 0, sizeof(params));
+    ring.sqRing = ring.cqRing = MAP_FAILED;
+    ring.sqes = (struct io_uring_sqe *)MAP_FAILED;
+    ring.fd = (int)syscall(__NR_io_uring_setup, entries, &params);
+    if (ring.fd < 0)
+        return 0;
+    if (!ringSupportsRead())
+    {
+        close(ring.fd);
+        return 0;
+    }
+
+    ring.sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    ring.cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    ring.sqesSize = params.sq_entries * sizeof(struct io_uring_sqe);
+
+    ring.sqRing = mmap(NULL, ring.sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring.fd, IORING_OFF_SQ_RING);
+    ring.cqRing = mmap(NULL, ring.cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring.fd, IORING_OFF_CQ_RING);
+    ring.sqes = (struct io_uring_sqe *)mmap(NULL, ring.sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring.fd, IORING_OFF_SQES);
+    if (ring.sqRing == MAP_FAILED || ring.cqRing == MAP_FAILED || ring.sqes == MAP_FAILED)
+    {
+        ringFree();
+        return 0;
+    }
+
+    sq = (unsigned char *)ring.sqRing;
+    cq = (unsigned char *)ring.cqRing;
+    ring.sqHead = (unsigned *)(sq + params.sq_off.head);
+    ring.sqTail = (unsigned *)(sq + params.sq_off.tail);
+    ring.sqMask = (unsigned *)(sq + params.sq_off.ring_mask);
+    ring.sqArray = (unsigned *)(sq + params.sq_off.array);
+    ring.cqHead = (unsigned *)(cq + params.cq_off.head);
+    ring.cqTail = (unsigned *)(cq + params.cq_off.tail);
+    ring.cqMask = (unsigned *)(cq + params.cq_off.ring_mask);
+    ring.cqes = (struct io_uring_cqe *)(cq + params.cq_off.cqes);
+    return 1;
+}
+
+/// <summary>
+/// Queue a read of the rest of the slot's file. user_data carries the slot.
+/// </summary>
+static void ringQueueRead(LoadSlot *slot)
+{
+    unsigned tail = *ring.sqTail;
+    unsigned index = tail & *ring.sqMask;
+    struct io_uring_sqe *sqe = &ring.sqes[index];
+
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = IORING_OP_READ;
+    sqe->fd = slot->fd;
+    sqe->addr = (unsigned long long)(slot->file.data + slot->file.len);
+    sqe->len = (unsigned)(slot->size - slot->file.len);
+    sqe->off = slot->file.len;
+    sqe->user_data = (unsigned long long)slot;
+
+    ring.sqArray[index] = index;
+    __atomic_store_n(ring.sqTail, tail + 1, __ATOMIC_RELEASE);
+}
+
+static void finishSlot(LoadSlot *slot)
+{
+    close(slot->fd);
+    publishSlot(slot);
+}
+
+/// <summary>
+/// io_uring backend: a single thread keeps up to LOADER_QUEUE_DEPTH reads
+/// outstanding and publishes files as their reads complete.
+/// </summary>
+static int uringWorker(void *arg)
+{
+    LoadSlot *slot;
+    struct io_uring_cqe *cqe;
+    unsigned head;
+    unsigned submit = 0;
+    int inFlight = 0;
+    int next = 0;
+
+    (void)arg;
+    while (next < loadCount || inFlight > 0)
+    {
+        while (next < loadCount && inFlight < LOADER_QUEUE_DEPTH)
+        {
+            // Only block for a free slot when nothing else can make progress.
+            slot = claimSlot(next, inFlight == 0);
+            if (slot == NULL)
+                break;
+            next++;
+
+            slot->fd = openSlot(slot);
+            if (slot->fd < 0)
+            {
+                publishSlot(slot);
+            }
+            else if (slot->size == 0)
+            {
+                finishSlot(slot);
+            }
+            else
+            {
+                ringQueueRead(slot);
+                submit++;
+                inFlight++;
+            }
+        }
+
+        if (inFlight == 0)
+            continue;
+
+        TRACE_BEGIN(start);
+        syscall(__NR_io_uring_enter, ring.fd, submit, 1, IORING_ENTER_GETEVENTS, NULL, 0);
+        TRACE_END(start, "read", NULL);
+        submit = 0;
+
+        head = *ring.cqHead;
+        while (head != __atomic_load_n(ring.cqTail, __ATOMIC_ACQUIRE))
+        {
+            cqe = &ring.cqes[head & *ring.cqMask];
+            slot = (LoadSlot *)cqe->user_data;
+            head++;
+
+            if (cqe->res > 0)
+                slot->file.len += (size_t)cqe->res;
+            else if (cqe->res == -EINVAL || cqe->res == -EOPNOTSUPP)
+                // The kernel can't read this file through the ring.
+                preadSlot(slot, slot->fd);
+            else if (cqe->res < 0)
+                slot->file.status = IO_ERROR;
+
+            if (cqe->res > 0 && slot->file.len < slot->size)
+            {
+                // Short read: queue the remainder for the next enter.
+                ringQueueRead(slot);
+                submit++;
+                continue;
+            }
+
+            finishSlot(slot);
+            inFlight--;
+        }
+        __atomic_store_n(ring.cqHead, head, __ATOMIC_RELEASE);
+    }
+
+    ringFree();
+    return 0;
+}
+
+#endif
+
+/***************************************************************/
+
+int loaderStart(char **fileNames, int count, LoaderBackend backend)
+{
+    int i;
+
+    loadNames = fileNames;
+    loadCount = count;
+    atomic_init(&nextFile, 0);
+    loadThreadCount = 0;
+
+    for (i = 0; i < LOADER_SLOTS; i++)
+    {
+        slots[i].state = SLOT_FREE;
+        slots[i].nextIndex = i;
+        slots[i].file.data = NULL;
+        slots[i].capacity = 0;
+    }
+    for (i = 0; i < LOADER_SLOTS && i < count; i++)
+    {
+        slots[i].file.data = (unsigned char *)memAlloc(MEM_INPUT, INITIAL_CAPACITY);
+        if (slots[i].file.data == NULL)
+            return IO_ERROR;
+        slots[i].capacity = INITIAL_CAPACITY;
+    }
+
+    if (mtx_init(&loadLock, mtx_plain) != thrd_success || cnd_init(&loadChanged) != thrd_success)
+        return IO_ERROR;
+
+#ifdef __linux__
+    if (backend == LOADER_BACKEND_AUTO && ringInit(LOADER_QUEUE_DEPTH))
+    {
+        if (thrd_create(&loadThreads[0], uringWorker, NULL) == thrd_success)
+        {
+            loadThreadCount = 1;
+            return IO_SUCCESS;
+        }
+        ringFree();
+    }
+#else
+    (void)backend;
+#endif
+
+    for (i = 0; i < LOADER_THREADS; i++)
+    {
+        if (thrd_create(&loadThreads[i], preadWorker, NULL) != thrd_success)
+            break;
+        loadThreadCount++;
+    }
+    return loadThreadCount > 0 ? IO_SUCCESS : IO_ERROR;
+}
+
+LoadedFile *loaderWait(int index)
+{
+    LoadSlot *slot = &slots[index % LOADER_SLOTS];
+
+    TRACE_BEGIN(start);
+    mtx_lock(&loadLock);
+    while (slot->state != SLOT_READY || slot->nextIndex != index + LOADER_SLOTS)
+        cnd_wait(&loadChanged, &loadLock);
+    mtx_unlock(&loadLock);
+    TRACE_END(start, "wait", loadNames[index]);
+
+    return &slot->file;
+}
+
+void loaderRelease(LoadedFile *file)
+{
+    LoadSlot *slot = (LoadSlot *)file;
+
+    mtx_lock(&loadLock);
+    slot->state = SLOT_FREE;
+    cnd_broadcast(&loadChanged);
+    mtx_unlock(&loadLock);
+}
+
+void loaderStop(void)
+{
+    int i;
+
+    for (i = 0; i < loadThreadCount; i++)
+        thrd_join(loadThreads[i], NULL);
+    loadThreadCount = 0;
+
+    for (i = 0; i < LOADER_SLOTS; i++)
+    {
+        memFree(slots[i].file.data);
+        slots[i].file.data = NULL;
+        slots[i].capacity = 0;
+    }
+
+    cnd_destroy(&loadChanged);
+    mtx_destroy(&loadLock);
+}
+
+#endif
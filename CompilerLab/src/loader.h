@@ -0,0 +1,48 @@
+/* 
+ * @copyright (c) 2026, agent
+ * @author agent
+ * @version 1.0
+ */
+
+#ifndef __LOADER_H__
+#define __LOADER_H__
+
+#include <stddef.h>
+
+#define LOADER_SLOTS 64
+#define LOADER_THREADS 4
+#define LOADER_QUEUE_DEPTH 32
+
+// Loading ahead is opt-in (-preload). With the files in the page cache a
+// plain sequential scan is faster, as the reads cost less than the hand-off
+// to the scanning thread; it pays off when reads block, on a cold cache or
+// slow storage. Of the two backends, io_uring is the default since it
+// beats the thread pool on the bench corpus.
+typedef enum
+{
+    LOADER_BACKEND_AUTO, // io_uring when the kernel can read through it, else threads
+    LOADER_BACKEND_PREAD // pool of LOADER_THREADS threads doing open/pread/close
+} LoaderBackend;
+
+/// <summary>
+/// A whole input file loaded into a pooled buffer. status is IO_SUCCESS
+/// or IO_ERROR.
+/// </summary>
+typedef struct
+{
+    char *fileName;
+    unsigned char *data;
+    size_t len;
+    int status;
+} LoadedFile;
+
+// Start loading fileNames in order, at most LOADER_SLOTS files ahead of
+// the consumer. Returns IO_ERROR if background loading is unavailable.
+int loaderStart(char **fileNames, int count, LoaderBackend backend);
+// Block until file index has been loaded. Files must be taken in order.
+LoadedFile *loaderWait(int index);
+// Hand the buffer back to the pool once the file has been scanned.
+void loaderRelease(LoadedFile *file);
+void loaderStop(void);
+
+#endif
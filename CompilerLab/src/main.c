@@ -0,0 +1,12 @@
+/* Scanner driver
+ * @copyright (c) 2008, Hedspi, Hanoi University of Technology
+ * @author Huu-Duc Nguyen
+ * @version 1.0
+ */
+
+#include "driver.h"
+
+int main(int argc, char* argv[])
+{
+    return scannerMain(argc, argv);
+}
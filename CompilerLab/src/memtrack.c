@@ -0,0 +1,284 @@
+/*
+ * @copyright (c) 2026, agent
+ * @author agent
+ * @version 1.0
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+
+#include "platform.h"
+#include "memtrack.h"
+
+#define FILE_NAME_SIZE 256
+
+/// <summary>
+/// Prefix of every block: its size and subsystem, so frees need neither.
+/// The union keeps the caller's part aligned as malloc would.
+/// </summary>
+typedef union
+{
+    struct
+    {
+        size_t size;
+        int subsystem;
+    } info;
+    long double alignLongDouble;
+    long long alignLongLong;
+    void *alignPointer;
+} BlockHeader;
+
+static MemAllocator allocator = {malloc, realloc, free};
+
+// Indexed by subsystem, with the total last.
+static atomic_llong processCurrent[MEM_SUBSYSTEMS + 1];
+static atomic_llong processPeak[MEM_SUBSYSTEMS + 1];
+static atomic_llong processAllocations[MEM_SUBSYSTEMS + 1];
+static atomic_llong threadPeak;
+
+static atomic_llong filePeak;
+static atomic_flag filePeakLock = ATOMIC_FLAG_INIT;
+static char filePeakName[FILE_NAME_SIZE];
+
+static THREAD_LOCAL MemStats threadStats;
+static THREAD_LOCAL MemStats fileStats;
+static THREAD_LOCAL const char *fileName;
+static THREAD_LOCAL char fileNameCopy[FILE_NAME_SIZE];
+
+static const char *subsystemNames[MEM_SUBSYSTEMS] = {"input", "tokens", "output", "diagnostics", "index", "analytics"};
+
+void memSetAllocator(const MemAllocator *newAllocator)
+{
+    if (newAllocator != NULL)
+        allocator = *newAllocator;
+    else
+    {
+        allocator.allocate = malloc;
+        allocator.reallocate = realloc;
+        allocator.release = free;
+    }
+}
+
+static void raiseTo(atomic_llong *peak, long long value)
+{
+    long long seen = atomic_load_explicit(peak, memory_order_relaxed);
+    while (value > seen && !atomic_compare_exchange_weak_explicit(peak, &seen, value, memory_order_relaxed,
+                                                                  memory_order_relaxed))
+        ;
+}
+
+static void charge(MemUsage *usage, long long delta, int allocated)
+{
+    usage->current += delta;
+    if (usage->current > usage->peak)
+        usage->peak = usage->current;
+    usage->allocations += allocated;
+}
+
+/// <summary>
+/// Keep peak as the highest file peak, with the current file's name.
+/// </summary>
+static void recordFilePeak(long long peak)
+{
+    if (peak < atomic_load_explicit(&filePeak, memory_order_relaxed))
+        return;
+
+    while (atomic_flag_test_and_set_explicit(&filePeakLock, memory_order_acquire))
+        ;
+    if (peak > atomic_load_explicit(&filePeak, memory_order_relaxed) || filePeakName[0] == '\0')
+    {
+        atomic_store_explicit(&filePeak, peak, memory_order_relaxed);
+        memcpy(filePeakName, fileNameCopy, FILE_NAME_SIZE);
+    }
+    atomic_flag_clear_explicit(&filePeakLock, memory_order_release);
+}
+
+static void account(int subsystem, long long delta, int allocated)
+{
+    long long now;
+
+    now = atomic_fetch_add_explicit(&processCurrent[subsystem], delta, memory_order_relaxed) + delta;
+    raiseTo(&processPeak[subsystem], now);
+    now = atomic_fetch_add_explicit(&processCurrent[MEM_SUBSYSTEMS], delta, memory_order_relaxed) + delta;
+    raiseTo(&processPeak[MEM_SUBSYSTEMS], now);
+    if (allocated)
+    {
+        atomic_fetch_add_explicit(&processAllocations[subsystem], 1, memory_order_relaxed);
+        atomic_fetch_add_explicit(&processAllocations[MEM_SUBSYSTEMS], 1, memory_order_relaxed);
+    }
+
+    charge(&threadStats.subsystems[subsystem], delta, allocated);
+    charge(&threadStats.total, delta, allocated);
+    if (delta > 0 && threadStats.total.current == threadStats.total.peak)
+        raiseTo(&threadPeak, threadStats.total.peak);
+
+    if (fileName != NULL)
+    {
+        charge(&fileStats.subsystems[subsystem], delta, allocated);
+        charge(&fileStats.total, delta, allocated);
+        if (delta > 0 && fileStats.total.current == fileStats.total.peak)
+            recordFilePeak(fileStats.total.peak);
+    }
+}
+
+void *memAlloc(MemSubsystem subsystem, size_t size)
+{
+    BlockHeader *header = (BlockHeader *)allocator.allocate(sizeof(BlockHeader) + size);
+
+    if (header == NULL)
+        return NULL;
+    header->info.size = size;
+    header->info.subsystem = subsystem;
+    account(subsystem, (long long)size, 1);
+    return header + 1;
+}
+
+void *memCalloc(MemSubsystem subsystem, size_t count, size_t size)
+{
+    void *block;
+
+    if (size != 0 && count > ((size_t)-1 - sizeof(BlockHeader)) / size)
+        return NULL;
+    block = memAlloc(subsystem, count * size);
+    if (block != NULL)
+        memset(block, 0, count * size);
+    return block;
+}
+
+void *memRealloc(MemSubsystem subsystem, void *block, size_t size)
+{
+    BlockHeader *header;
+    size_t oldSize;
+
+    if (block == NULL)
+        return memAlloc(subsystem, size);
+
+    header = (BlockHeader *)block - 1;
+    oldSize = header->info.size;
+    header = (BlockHeader *)allocator.reallocate(header, sizeof(BlockHeader) + size);
+    if (header == NULL)
+        return NULL;
+    header->info.size = size;
+    account(header->info.subsystem, (long long)size - (long long)oldSize, 0);
+    return header + 1;
+}
+
+void memFree(void *block)
+{
+    BlockHeader *header;
+
+    if (block == NULL)
+        return;
+    header = (BlockHeader *)block - 1;
+    account(header->info.subsystem, -(long long)header->info.size, 0);
+    allocator.release(header);
+}
+
+void memAccount(MemSubsystem subsystem, long long delta)
+{
+    account(subsystem, delta, delta > 0);
+}
+
+void *memBufferStream(FILE *stream, size_t size)
+{
+    void *buffer = memAlloc(MEM_OUTPUT, size);
+
+    if (buffer != NULL && setvbuf(stream, (char *)buffer, _IOFBF, size) != 0)
+    {
+        memFree(buffer);
+        return NULL;
+    }
+    return buffer;
+}
+
+void memBeginFile(const char *name)
+{
+    int i;
+
+    if (name == fileName)
+        return;
+
+    fileStats = threadStats;
+    for (i = 0; i < MEM_SUBSYSTEMS; i++)
+    {
+        fileStats.subsystems[i].peak = fileStats.subsystems[i].current;
+        fileStats.subsystems[i].allocations = 0;
+    }
+    fileStats.total.peak = fileStats.total.current;
+    fileStats.total.allocations = 0;
+
+    fileName = name;
+    if (name != NULL)
+    {
+        strncpy(fileNameCopy, name, FILE_NAME_SIZE - 1);
+        fileNameCopy[FILE_NAME_SIZE - 1] = '\0';
+        recordFilePeak(fileStats.total.peak);
+    }
+}
+
+void memProcessStats(MemStats *stats)
+{
+    MemUsage *usage;
+    int i;
+
+    for (i = 0; i <= MEM_SUBSYSTEMS; i++)
+    {
+        usage = i < MEM_SUBSYSTEMS ? &stats->subsystems[i] : &stats->total;
+        usage->current = atomic_load_explicit(&processCurrent[i], memory_order_relaxed);
+        usage->peak = atomic_load_explicit(&processPeak[i], memory_order_relaxed);
+        usage->allocations = atomic_load_explicit(&processAllocations[i], memory_order_relaxed);
+    }
+}
+
+void memThreadStats(MemStats *stats)
+{
+    *stats = threadStats;
+}
+
+void memFileStats(MemStats *stats)
+{
+    *stats = fileStats;
+}
+
+long long memThreadPeak(void)
+{
+    return atomic_load_explicit(&threadPeak, memory_order_relaxed);
+}
+
+long long memFilePeak(char *name, size_t size)
+{
+    long long peak;
+
+    while (atomic_flag_test_and_set_explicit(&filePeakLock, memory_order_acquire))
+        ;
+    peak = atomic_load_explicit(&filePeak, memory_order_relaxed);
+    if (size > 0)
+    {
+        strncpy(name, filePeakName, size - 1);
+        name[size - 1] = '\0';
+    }
+    atomic_flag_clear_explicit(&filePeakLock, memory_order_release);
+    return peak;
+}
+
+void memPrintReport(FILE *out)
+{
+    char name[FILE_NAME_SIZE];
+    long long peak;
+    MemStats stats;
+    int i;
+
+    memProcessStats(&stats);
+    fprintf(out, "%-12s %14s %14s %12s\n", "memory", "current", "peak", "allocations");
+    for (i = 0; i < MEM_SUBSYSTEMS; i++)
+        fprintf(out, "%-12s %14lld %14lld %12lld\n", subsystemNames[i], stats.subsystems[i].current,
+                stats.subsystems[i].peak, stats.subsystems[i].allocations);
+    fprintf(out, "%-12s %14lld %14lld %12lld\n", "total", stats.total.current, stats.total.peak,
+            stats.total.allocations);
+    fprintf(out, "thread peak  %14lld\n", memThreadPeak());
+    peak = memFilePeak(name, sizeof(name));
+    if (name[0] != '\0')
+        fprintf(out, "file peak    %14lld %s\n", peak, name);
+}
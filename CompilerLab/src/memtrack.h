@@ -0,0 +1,96 @@
+/*
+ * @copyright (c) 2026, agent
+ * @author agent
+ * @version 1.0
+ */
+
+#ifndef __MEMTRACK_H__
+#define __MEMTRACK_H__
+
+#include <stdio.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// What an allocation is for. Every heap block of the scanner is charged to
+// exactly one of these.
+typedef enum
+{
+    MEM_INPUT,       // file contents, read buffers and pipeline blocks
+    MEM_TOKENS,      // heap tokens, token batches and the pipeline queues
+    MEM_OUTPUT,      // output stream buffers and per-entry output state
+    MEM_DIAGNOSTICS, // trace events
+    MEM_INDEX,       // identifier index, checkpoints and archive tables
+    MEM_ANALYTICS,   // -stats accumulators
+    MEM_SUBSYSTEMS
+} MemSubsystem;
+
+typedef struct
+{
+    long long current;     // bytes live now
+    long long peak;        // most bytes live at once
+    long long allocations; // blocks allocated
+} MemUsage;
+
+typedef struct
+{
+    MemUsage subsystems[MEM_SUBSYSTEMS];
+    MemUsage total;
+} MemStats;
+
+// Where the bytes come from. The default is malloc, realloc and free.
+typedef struct
+{
+    void *(*allocate)(size_t size);
+    void *(*reallocate)(void *block, size_t size);
+    void (*release)(void *block);
+} MemAllocator;
+
+// Install allocator, or the default for NULL. Only while nothing allocated
+// through the previous one is still live.
+void memSetAllocator(const MemAllocator *allocator);
+
+void *memAlloc(MemSubsystem subsystem, size_t size);
+void *memCalloc(MemSubsystem subsystem, size_t count, size_t size);
+// A NULL block is allocated for subsystem; otherwise the block stays
+// charged to the subsystem it was allocated for.
+void *memRealloc(MemSubsystem subsystem, void *block, size_t size);
+void memFree(void *block);
+// Charge delta bytes to subsystem for a block allocated or released (when
+// negative) without the functions above, such as one callers may free().
+void memAccount(MemSubsystem subsystem, long long delta);
+
+// Give stream a full buffer of size bytes charged to MEM_OUTPUT instead of
+// the one stdio would allocate unseen. The buffer is returned so it can be
+// freed once the stream is closed.
+void *memBufferStream(FILE *stream, size_t size);
+
+// Start charging the calling thread's allocations to fileName as well.
+// A no-op while fileName is already the current file.
+void memBeginFile(const char *fileName);
+
+// Usage of the whole process. Peaks are exact per subsystem and for the
+// total; they need not have been reached at the same time.
+void memProcessStats(MemStats *stats);
+// Usage of the calling thread. Blocks freed by another thread than the one
+// that allocated them are subtracted from the freeing thread.
+void memThreadStats(MemStats *stats);
+// Usage of the calling thread since its current file began. Current bytes
+// include what earlier files left allocated, as they count toward the peak.
+void memFileStats(MemStats *stats);
+// Highest total peak of any single thread.
+long long memThreadPeak(void);
+// Highest thread peak reached while lexing a single file, with its name
+// copied to name. Returns 0 if no file began.
+long long memFilePeak(char *name, size_t size);
+
+// Print all of the above as a table.
+void memPrintReport(FILE *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
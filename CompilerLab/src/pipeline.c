@@ -0,0 +1,347 @@
+/* 
+ * @copyright (c) 2026, agent
+ * @author agent
+ * @version 1.0
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <threads.h>
+
+#include "reader.h"
+#include "token.h"
+#include "error.h"
+#include "trace.h"
+#include "memtrack.h"
+#include "queue.h"
+#include "scanner.h"
+#include "pipeline.h"
+
+/// <summary>
+/// A block of the file as read. The reader refills it once the lexer hands
+/// it back, so at most PIPELINE_BLOCK_COUNT blocks of the file are held.
+/// </summary>
+typedef struct
+{
+    size_t len;
+    unsigned char data[PIPELINE_BLOCK_SIZE];
+} InputBlock;
+
+/// <summary>
+/// Tokens handed from the lexer to the writer, with copies of their lexemes:
+/// the blocks those were read from may be refilled before they are printed.
+/// A negative count marks the end of the stream.
+/// </summary>
+typedef struct
+{
+    int count;
+    size_t textLen;
+    char *text;
+    Token tokens[PIPELINE_BATCH_SIZE];
+} TokenBatch;
+
+static FILE *stream;
+static char *streamName;
+static int readError;
+
+static InputBlock *blocks;
+static TokenBatch *batches;
+static char *batchText;
+static size_t batchTextSize;
+
+// Reader -> lexer, and the recycled blocks going back.
+static SpscQueue fullBlocks, freeBlocks;
+// Lexer -> writer, and the recycled batches going back.
+static SpscQueue fullBatches, freeBatches;
+
+static thrd_t readerThread, writerThread;
+static int writerRunning;
+
+static InputBlock *currentBlock;
+static TokenBatch *currentBatch;
+static int endOfInput;
+static atomic_int stopReading;
+static TokenSink writerSink;
+static FILE *writerOutput;
+static void (*previousErrorHook)(ErrorCode err, int lineNo, int colNo);
+
+/***************************************************************/
+
+static int readerStage(void *arg)
+{
+    InputBlock *block;
+
+    (void)arg;
+    do
+    {
+        // Blocks until the lexer hands one back, which bounds the read-ahead.
+        block = (InputBlock *)spscPop(&freeBlocks);
+
+        TRACE_BEGIN(start);
+        block->len = atomic_load(&stopReading) ? 0 : fread(block->data, 1, PIPELINE_BLOCK_SIZE, stream);
+        TRACE_END(start, "read", streamName);
+
+        if (block->len == 0 && ferror(stream))
+            readError = 1;
+
+        // An empty block tells the lexer the input has ended.
+        spscPush(&fullBlocks, block);
+    } while (block->len > 0);
+
+    return 0;
+}
+
+static int writerStage(void *arg)
+{
+    TokenBatch *batch;
+    int i;
+
+    (void)arg;
+    // The output stream is per thread; adopt the lexer's.
+    outputStream = writerOutput;
+    while (1)
+    {
+        batch = (TokenBatch *)spscPop(&fullBatches);
+        if (batch->count < 0)
+            break;
+
+        TRACE_BEGIN(start);
+        for (i = 0; i < batch->count; i++)
+            writerSink(&batch->tokens[i]);
+        TRACE_END(start, "print", streamName);
+
+        spscPush(&freeBatches, batch);
+    }
+
+    TRACE_BEGIN(flushStart);
+    fflush(outputFile());
+    TRACE_END(flushStart, "flush", streamName);
+    return 0;
+}
+
+/***************************************************************/
+
+/// <summary>
+/// InputSource for the lexer: recycle the exhausted block and wait for the next.
+/// </summary>
+static size_t nextBlock(const unsigned char **block)
+{
+    if (endOfInput)
+        return 0;
+
+    if (currentBlock != NULL)
+        spscPush(&freeBlocks, currentBlock);
+
+    currentBlock = (InputBlock *)spscPop(&fullBlocks);
+    if (currentBlock->len == 0)
+        endOfInput = 1;
+
+    *block = currentBlock->data;
+    return currentBlock->len;
+}
+
+static void emitToken(Token *token)
+{
+    Token *copy;
+
+    // Send the batch on early should the lexeme not fit in what is left.
+    if (currentBatch != NULL && currentBatch->textLen + token->length > batchTextSize)
+    {
+        spscPush(&fullBatches, currentBatch);
+        currentBatch = NULL;
+    }
+    if (currentBatch == NULL)
+    {
+        currentBatch = (TokenBatch *)spscPop(&freeBatches);
+        currentBatch->count = 0;
+        currentBatch->textLen = 0;
+    }
+
+    copy = &currentBatch->tokens[currentBatch->count++];
+    *copy = *token;
+    if (token->length > 0)
+    {
+        copy->lexeme = currentBatch->text + currentBatch->textLen;
+        memcpy(currentBatch->text + currentBatch->textLen, token->lexeme, token->length);
+        currentBatch->textLen += token->length;
+    }
+
+    if (currentBatch->count == PIPELINE_BATCH_SIZE)
+    {
+        spscPush(&fullBatches, currentBatch);
+        currentBatch = NULL;
+    }
+}
+
+/// <summary>
+/// Send the pending batch and the end marker, then wait for the writer.
+/// </summary>
+static void drainPipeline(void)
+{
+    TokenBatch *end;
+
+    if (!writerRunning)
+        return;
+
+    if (currentBatch != NULL)
+    {
+        spscPush(&fullBatches, currentBatch);
+        currentBatch = NULL;
+    }
+
+    end = (TokenBatch *)spscPop(&freeBatches);
+    end->count = -1;
+    spscPush(&fullBatches, end);
+
+    thrd_join(writerThread, NULL);
+    writerRunning = 0;
+}
+
+/// <summary>
+/// Let the reader wind down, skipping what it already read, and join it.
+/// </summary>
+static void stopReader(void)
+{
+    const unsigned char *skipped;
+
+    atomic_store(&stopReading, 1);
+    while (nextBlock(&skipped) > 0)
+        ;
+    thrd_join(readerThread, NULL);
+}
+
+static void freePipeline(void);
+
+/// <summary>
+/// errorHook while pipelined: diagnostics must follow the earlier tokens.
+/// The pipeline is torn down first in case the previous hook does not exit.
+/// </summary>
+static void drainOnError(ErrorCode err, int lineNo, int colNo)
+{
+    drainPipeline();
+    stopReader();
+    fclose(stream);
+    freePipeline();
+    tokenSink = writerSink;
+    errorHook = previousErrorHook;
+    if (previousErrorHook != NULL)
+        previousErrorHook(err, lineNo, colNo);
+}
+
+static int initPipeline(void)
+{
+    int i;
+
+    // Room for the lexemes of a full batch, and for the longest one alone.
+    batchTextSize = PIPELINE_BATCH_TEXT;
+    if ((size_t)maxIdentLen > batchTextSize)
+        batchTextSize = (size_t)maxIdentLen;
+    if ((size_t)maxNumLen > batchTextSize)
+        batchTextSize = (size_t)maxNumLen;
+
+    blocks = (InputBlock *)memAlloc(MEM_INPUT, PIPELINE_BLOCK_COUNT * sizeof(InputBlock));
+    batches = (TokenBatch *)memAlloc(MEM_TOKENS, PIPELINE_BATCH_COUNT * sizeof(TokenBatch));
+    batchText = (char *)memAlloc(MEM_TOKENS, PIPELINE_BATCH_COUNT * batchTextSize);
+    if (blocks == NULL || batches == NULL || batchText == NULL)
+        return IO_ERROR;
+
+    if (spscInit(&fullBlocks, PIPELINE_BLOCK_COUNT) == QUEUE_ERROR ||
+        spscInit(&freeBlocks, PIPELINE_BLOCK_COUNT) == QUEUE_ERROR ||
+        spscInit(&fullBatches, PIPELINE_BATCH_COUNT) == QUEUE_ERROR ||
+        spscInit(&freeBatches, PIPELINE_BATCH_COUNT) == QUEUE_ERROR)
+        return IO_ERROR;
+
+    for (i = 0; i < PIPELINE_BLOCK_COUNT; i++)
+        spscTryPush(&freeBlocks, &blocks[i]);
+    for (i = 0; i < PIPELINE_BATCH_COUNT; i++)
+    {
+        batches[i].text = batchText + i * batchTextSize;
+        spscTryPush(&freeBatches, &batches[i]);
+    }
+
+    currentBlock = NULL;
+    currentBatch = NULL;
+    endOfInput = 0;
+    readError = 0;
+    atomic_init(&stopReading, 0);
+    return IO_SUCCESS;
+}
+
+static void freePipeline(void)
+{
+    spscFree(&fullBlocks);
+    spscFree(&freeBlocks);
+    spscFree(&fullBatches);
+    spscFree(&freeBatches);
+    memFree(blocks);
+    memFree(batches);
+    memFree(batchText);
+    blocks = NULL;
+    batches = NULL;
+    batchText = NULL;
+}
+
+int scanPipelined(char *fileName)
+{
+    int status;
+
+    memBeginFile(fileName);
+    TRACE_BEGIN(fileStart);
+
+    TRACE_BEGIN(openStart);
+#ifdef _MSC_VER
+    fopen_s(&stream, fileName, "rt");
+#else
+    stream = fopen(fileName, "rt");
+#endif
+    TRACE_END(openStart, "open", fileName);
+    if (stream == NULL)
+        return IO_ERROR;
+    streamName = fileName;
+
+    writerOutput = outputStream;
+    if (initPipeline() == IO_ERROR ||
+        thrd_create(&writerThread, writerStage, NULL) != thrd_success)
+    {
+        freePipeline();
+        fclose(stream);
+        return IO_ERROR;
+    }
+    writerRunning = 1;
+
+    if (thrd_create(&readerThread, readerStage, NULL) != thrd_success)
+    {
+        drainPipeline();
+        freePipeline();
+        fclose(stream);
+        return IO_ERROR;
+    }
+    previousErrorHook = errorHook;
+    errorHook = drainOnError;
+
+    openInputSource(nextBlock);
+
+    // The lexer hands tokens to the writer, which passes them on to the sink.
+    writerSink = tokenSink;
+    tokenSink = emitToken;
+    status = scanTokens(fileName);
+    tokenSink = writerSink;
+
+    drainPipeline();
+    errorHook = previousErrorHook;
+    // Stopped early or not, this also waits for the end-of-input block.
+    stopReader();
+    if (readError)
+        status = IO_ERROR;
+
+    TRACE_BEGIN(closeStart);
+    fclose(stream);
+    TRACE_END(closeStart, "close", fileName);
+
+    freePipeline();
+
+    TRACE_END(fileStart, "file", fileName);
+    return status;
+}
@@ -0,0 +1,23 @@
+/* 
+ * @copyright (c) 2026, agent
+ * @author agent
+ * @version 1.0
+ */
+
+#ifndef __PIPELINE_H__
+#define __PIPELINE_H__
+
+#define PIPELINE_BLOCK_SIZE 65536
+#define PIPELINE_BLOCK_COUNT 8
+#define PIPELINE_BATCH_SIZE 256
+#define PIPELINE_BATCH_COUNT 8
+// Lexeme bytes a batch holds, unless maxIdentLen or maxNumLen is larger.
+#define PIPELINE_BATCH_TEXT 4096
+
+/// <summary>
+/// Scan fileName with reading, lexing and printing on three threads joined
+/// by SPSC queues. Output is identical to scan().
+/// </summary>
+int scanPipelined(char *fileName);
+
+#endif
@@ -0,0 +1,19 @@
+/* 
+ * @copyright (c) 2026, agent
+ * @author agent
+ * @version 1.0
+ */
+
+#ifndef __PLATFORM_H__
+#define __PLATFORM_H__
+
+// Storage class for per-thread globals.
+#if defined(__cplusplus)
+#define THREAD_LOCAL thread_local
+#elif defined(_MSC_VER)
+#define THREAD_LOCAL __declspec(thread)
+#else
+#define THREAD_LOCAL _Thread_local
+#endif
+
+#endif
@@ -0,0 +1,83 @@
+/* 
+ * @copyright (c) 2026, agent
+ * @author agent
+ * @version 1.0
+ */
+
+#include <stdlib.h>
+#include <threads.h>
+#include "memtrack.h"
+#include "queue.h"
+
+#define SPIN_LIMIT 64
+
+int spscInit(SpscQueue *queue, size_t capacity)
+{
+    size_t size = 1;
+    while (size < capacity)
+        size <<= 1;
+
+    queue->slots = (void **)memCalloc(MEM_TOKENS, size, sizeof(void *));
+    if (queue->slots == NULL)
+        return QUEUE_ERROR;
+
+    queue->mask = size - 1;
+    atomic_init(&queue->head, 0);
+    atomic_init(&queue->tail, 0);
+    return QUEUE_SUCCESS;
+}
+
+void spscFree(SpscQueue *queue)
+{
+    memFree(queue->slots);
+    queue->slots = NULL;
+}
+
+int spscTryPush(SpscQueue *queue, void *item)
+{
+    size_t tail = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+    size_t head = atomic_load_explicit(&queue->head, memory_order_acquire);
+
+    if (tail - head > queue->mask)
+        return QUEUE_ERROR;
+
+    queue->slots[tail & queue->mask] = item;
+    atomic_store_explicit(&queue->tail, tail + 1, memory_order_release);
+    return QUEUE_SUCCESS;
+}
+
+void *spscTryPop(SpscQueue *queue)
+{
+    size_t head = atomic_load_explicit(&queue->head, memory_order_relaxed);
+    size_t tail = atomic_load_explicit(&queue->tail, memory_order_acquire);
+    void *item;
+
+    if (head == tail)
+        return NULL;
+
+    item = queue->slots[head & queue->mask];
+    atomic_store_explicit(&queue->head, head + 1, memory_order_release);
+    return item;
+}
+
+void spscPush(SpscQueue *queue, void *item)
+{
+    int spins = 0;
+    while (spscTryPush(queue, item) == QUEUE_ERROR)
+    {
+        if (++spins > SPIN_LIMIT)
+            thrd_yield();
+    }
+}
+
+void *spscPop(SpscQueue *queue)
+{
+    int spins = 0;
+    void *item;
+    while ((item = spscTryPop(queue)) == NULL)
+    {
+        if (++spins > SPIN_LIMIT)
+            thrd_yield();
+    }
+    return item;
+}
@@ -0,0 +1,38 @@
+/* 
+ * @copyright (c) 2026, agent
+ * @author agent
+ * @version 1.0
+ */
+
+#ifndef __QUEUE_H__
+#define __QUEUE_H__
+
+#include <stddef.h>
+#include <stdatomic.h>
+
+#define QUEUE_ERROR 0
+#define QUEUE_SUCCESS 1
+
+/// <summary>
+/// Bounded lock-free ring for exactly one producer and one consumer thread.
+/// Items are non-NULL pointers; capacity is rounded up to a power of two.
+/// </summary>
+typedef struct
+{
+    void **slots;
+    size_t mask;
+    _Alignas(64) atomic_size_t head;
+    _Alignas(64) atomic_size_t tail;
+} SpscQueue;
+
+int spscInit(SpscQueue *queue, size_t capacity);
+void spscFree(SpscQueue *queue);
+
+int spscTryPush(SpscQueue *queue, void *item);
+void *spscTryPop(SpscQueue *queue);
+
+// Blocking variants, spinning and then yielding while the ring is full/empty.
+void spscPush(SpscQueue *queue, void *item);
+void *spscPop(SpscQueue *queue);
+
+#endif
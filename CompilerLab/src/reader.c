@@ -5,15 +5,177 @@
  */
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifndef _MSC_VER
+#include <sys/types.h>
+#endif
 #include "reader.h"
+#include "trace.h"
+#include "memtrack.h"
+#include "platform.h"
+
+// Bytes read from a file at a time, which is all of it that is held.
+#define INPUT_CHUNK_SIZE 65536
+// Longest stretch readChar consumes between calls to the InputCheck.
+#define INPUT_SLICE_SIZE 65536
+// Smallest allocation for lexemes kept across blocks.
+#define INPUT_CARRY_SIZE 256
+
+// Scanner state is per thread so that several files can be scanned at once.
+THREAD_LOCAL FILE *inputStream;
+THREAD_LOCAL FILE *outputStream;
+THREAD_LOCAL int lineNo, colNo;
+THREAD_LOCAL int currentChar;
+
+static THREAD_LOCAL char *inputFileName;
+static THREAD_LOCAL unsigned char *streamBuffer;
+static THREAD_LOCAL InputSource inputSource;
+static THREAD_LOCAL InputCheck inputCheck;
+THREAD_LOCAL const unsigned char *inputBlock;
+THREAD_LOCAL size_t inputPos, inputLen;
+THREAD_LOCAL long long inputBlockOffset;
+THREAD_LOCAL long long inputLexemeStart = -1;
+
+// The block the source last supplied, where it starts in the input, and the
+// part of it not yet handed to readChar.
+static THREAD_LOCAL const unsigned char *sourceBase;
+static THREAD_LOCAL size_t sourceSize;
+static THREAD_LOCAL long long sourceOffset;
+static THREAD_LOCAL const unsigned char *sourceBlock;
+static THREAD_LOCAL size_t sourceLen;
+
+// The start of a lexeme that crossed out of its block: carryLen bytes of
+// input from carryOffset.
+static THREAD_LOCAL unsigned char *carry;
+static THREAD_LOCAL size_t carryLen, carryCapacity;
+static THREAD_LOCAL long long carryOffset;
+
+static THREAD_LOCAL const unsigned char *memoryData;
+static THREAD_LOCAL size_t memoryLen;
+
+/// <summary>
+/// Append len bytes to the carry. Out of memory, the lexeme is cut short.
+/// </summary>
+static void appendCarry(const unsigned char *data, size_t len)
+{
+    unsigned char *grown;
+    size_t capacity;
+
+    if (carryLen + len > carryCapacity)
+    {
+        capacity = carryCapacity > 0 ? carryCapacity : INPUT_CARRY_SIZE;
+        while (capacity < carryLen + len)
+            capacity *= 2;
+        grown = (unsigned char *)memRealloc(MEM_INPUT, carry, capacity);
+        if (grown == NULL)
+            return;
+        carry = grown;
+        carryCapacity = capacity;
+    }
+    memcpy(carry + carryLen, data, len);
+    carryLen += len;
+}
 
-FILE *inputStream;
-int lineNo, colNo;
-int currentChar;
+/// <summary>
+/// The current block is about to be given up: copy what it holds of the
+/// lexeme being read, after what earlier blocks held of it.
+/// </summary>
+static void keepLexeme(void)
+{
+    if (inputLexemeStart < 0 || sourceSize == 0)
+        return;
+
+    if (inputLexemeStart >= sourceOffset)
+    {
+        carryOffset = inputLexemeStart;
+        carryLen = 0;
+        appendCarry(sourceBase + (inputLexemeStart - sourceOffset),
+                    sourceSize - (size_t)(inputLexemeStart - sourceOffset));
+    }
+    else if (carryOffset == inputLexemeStart && carryOffset + (long long)carryLen == sourceOffset)
+    {
+        appendCarry(sourceBase, sourceSize);
+    }
+}
+
+const char *inputLexeme(long long offset, size_t length)
+{
+    long long end = offset + (long long)length;
+    long long kept;
+
+    if (offset >= sourceOffset)
+        return (const char *)sourceBase + (offset - sourceOffset);
+
+    // It began in an earlier block: add the rest of it from this one.
+    kept = carryOffset + (long long)carryLen;
+    if (kept < end && kept >= sourceOffset)
+        appendCarry(sourceBase + (kept - sourceOffset), (size_t)(end - kept));
+    return (const char *)carry;
+}
+
+/// <summary>
+/// InputSource for openInputStream: the next chunk of inputStream, always
+/// read into the same buffer.
+/// </summary>
+static size_t readFromStream(const unsigned char **block)
+{
+    size_t n;
+
+    TRACE_BEGIN(start);
+    n = fread(streamBuffer, 1, INPUT_CHUNK_SIZE, inputStream);
+    TRACE_END(start, "read", inputFileName);
+
+    *block = streamBuffer;
+    return n;
+}
+
+/// <summary>
+/// InputSource for openInputBuffer: the whole buffer is a single block.
+/// </summary>
+static size_t readFromMemory(const unsigned char **block)
+{
+    size_t len = memoryLen;
+    *block = memoryData;
+    memoryData += len;
+    memoryLen = 0;
+    return len;
+}
+
+/// <summary>
+/// Move to the next slice of the current source block, fetching a new block
+/// when it is used up.
+/// </summary>
+void refillInput(void)
+{
+    if (sourceLen == 0)
+    {
+        keepLexeme();
+        sourceOffset += (long long)sourceSize;
+        sourceSize = sourceLen = inputSource(&sourceBlock);
+        sourceBase = sourceBlock;
+    }
+
+    inputBlockOffset = sourceOffset + (sourceBlock - sourceBase);
+    inputBlock = sourceBlock;
+    inputLen = sourceLen < INPUT_SLICE_SIZE ? sourceLen : INPUT_SLICE_SIZE;
+    inputPos = 0;
+    sourceBlock += inputLen;
+    sourceLen -= inputLen;
+
+    if (inputCheck != NULL && inputLen > 0)
+        inputCheck(inputBlockOffset);
+}
 
 int readChar(void)
 {
-    currentChar = getc(inputStream);
+    if (inputPos == inputLen)
+        refillInput();
+
+    if (inputLen == 0)
+        currentChar = EOF;
+    else
+        currentChar = inputBlock[inputPos++];
     colNo++;
     if (currentChar == '\n')
     {
@@ -23,22 +185,148 @@ int readChar(void)
     return currentChar;
 }
 
-int openInputStream(char *fileName)
+long long inputOffset(void)
+{
+    return inputBlockOffset + (long long)inputPos - 1;
+}
+
+/// <summary>
+/// Start reading source with its first byte at offset, and read it.
+/// </summary>
+static void startInput(InputSource source, long long offset)
 {
+    inputSource = source;
+    // A scan abandoned by longjmp may have left its check installed.
+    inputCheck = NULL;
+    inputLexemeStart = -1;
+    sourceBase = sourceBlock = inputBlock = NULL;
+    sourceSize = sourceLen = inputPos = inputLen = 0;
+    sourceOffset = inputBlockOffset = offset;
+    carryLen = 0;
+    lineNo = 1;
+    colNo = 0;
+    readChar();
+}
+
+/// <summary>
+/// Open fileName as inputStream with a chunk buffer to read it into.
+/// </summary>
+static int openStream(char *fileName)
+{
+    TRACE_BEGIN(start);
+    if (streamBuffer == NULL)
+    {
+        streamBuffer = (unsigned char *)memAlloc(MEM_INPUT, INPUT_CHUNK_SIZE);
+        if (streamBuffer == NULL)
+            return IO_ERROR;
+    }
 #ifdef _MSC_VER
     fopen_s(&inputStream, fileName, "rt");
 #else
     inputStream = fopen(fileName, "rt");
 #endif
+    TRACE_END(start, "open", fileName);
     if (inputStream == NULL)
         return IO_ERROR;
-    lineNo = 1;
-    colNo = 0;
-    readChar();
+    inputFileName = fileName;
+    return IO_SUCCESS;
+}
+
+int openInputStream(char *fileName)
+{
+    memBeginFile(fileName);
+    if (openStream(fileName) == IO_ERROR)
+        return IO_ERROR;
+
+    startInput(readFromStream, 0);
+    return IO_SUCCESS;
+}
+
+void openInputBuffer(const unsigned char *data, size_t len)
+{
+    memoryData = data;
+    memoryLen = len;
+    startInput(readFromMemory, 0);
+}
+
+void openInputSource(InputSource source)
+{
+    startInput(source, 0);
+}
+
+int openInputStreamAt(char *fileName, long long offset, int line, int col)
+{
+    memBeginFile(fileName);
+    if (offset < 0 || openStream(fileName) == IO_ERROR)
+        return IO_ERROR;
+
+#ifdef _MSC_VER
+    // Offsets count the characters of text mode, which seeking does not: read
+    // up to offset instead.
+    {
+        long long skipped = 0;
+        size_t n;
+
+        while (skipped < offset)
+        {
+            n = fread(streamBuffer, 1, offset - skipped < INPUT_CHUNK_SIZE ? (size_t)(offset - skipped) : INPUT_CHUNK_SIZE,
+                      inputStream);
+            if (n == 0)
+                break;
+            skipped += (long long)n;
+        }
+        if (skipped < offset)
+        {
+            fclose(inputStream);
+            inputStream = NULL;
+            return IO_ERROR;
+        }
+    }
+#else
+    // Only what comes from offset on is ever read.
+    if (fseeko(inputStream, (off_t)offset, SEEK_SET) != 0)
+    {
+        fclose(inputStream);
+        inputStream = NULL;
+        return IO_ERROR;
+    }
+#endif
+
+    startInput(readFromStream, offset);
+    if (currentChar == EOF)
+    {
+        fclose(inputStream);
+        inputStream = NULL;
+        return IO_ERROR;
+    }
+    lineNo = line;
+    colNo = col;
     return IO_SUCCESS;
 }
 
+void setInputCheck(InputCheck check)
+{
+    inputCheck = check;
+}
+
 void closeInputStream()
 {
+    TRACE_BEGIN(start);
     fclose(inputStream);
+    inputStream = NULL;
+    TRACE_END(start, "close", inputFileName);
+}
+
+void freeInputBuffer(void)
+{
+    memFree(streamBuffer);
+    memFree(carry);
+    streamBuffer = NULL;
+    carry = NULL;
+    carryLen = carryCapacity = 0;
+}
+
+FILE *outputFile(void)
+{
+    return outputStream != NULL ? outputStream : stdout;
 }
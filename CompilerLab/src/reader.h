@@ -10,8 +10,66 @@
 #define IO_ERROR 0
 #define IO_SUCCESS 1
 
+#include <stdio.h>
+#include <stddef.h>
+#include "platform.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// <summary>
+/// Supplies the next block of input through *block and returns its length,
+/// or 0 at end of input. A block may be reused once the next one is asked
+/// for; the reader keeps a copy of any lexeme that crosses into the next.
+/// </summary>
+typedef size_t (*InputSource)(const unsigned char **block);
+
+/// <summary>
+/// Called with the offset of each new slice of input, at least every 64 KB.
+/// </summary>
+typedef void (*InputCheck)(long long offset);
+
+// The file openInputStream opened; NULL once it is closed.
+extern THREAD_LOCAL FILE *inputStream;
+extern THREAD_LOCAL int lineNo, colNo;
+extern THREAD_LOCAL int currentChar;
+// Where this thread prints tokens and errors; NULL means stdout.
+extern THREAD_LOCAL FILE *outputStream;
+
+// The slice of input readChar is consuming, so that the lexer can inline it,
+// and the offset of its first byte in the input.
+extern THREAD_LOCAL const unsigned char *inputBlock;
+extern THREAD_LOCAL size_t inputPos, inputLen;
+extern THREAD_LOCAL long long inputBlockOffset;
+// Offset where the lexeme being read began, or -1 between lexemes. While it
+// is set, the part of the lexeme in a block being given up is copied.
+extern THREAD_LOCAL long long inputLexemeStart;
+
 int readChar(void);
+void refillInput(void);
+// Offset of currentChar in the input.
+long long inputOffset(void);
+// The length bytes of input from offset, which must end at or before
+// currentChar and began no earlier than inputLexemeStart when that was set.
+// Valid until the input moves on to another block.
+const char *inputLexeme(long long offset, size_t length);
+// Read fileName through a window of 64 KB, however large it is.
 int openInputStream(char *fileName);
+// Open fileName with the byte at offset as the current character, read at
+// line/col. Unlike openInputStream it does not read what comes before.
+int openInputStreamAt(char *fileName, long long offset, int line, int col);
+// data must stay valid while it is being scanned.
+void openInputBuffer(const unsigned char *data, size_t len);
+void openInputSource(InputSource source);
+void setInputCheck(InputCheck check);
 void closeInputStream(void);
+// Release this thread's input buffers; call before the thread exits.
+void freeInputBuffer(void);
+FILE *outputFile(void);
+
+#ifdef __cplusplus
+}
+#endif
 
 #endif
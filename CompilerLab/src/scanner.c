@@ -7,655 +7,279 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <setjmp.h>
+#include <limits.h>
 
 #include "reader.h"
 #include "charcode.h"
 #include "token.h"
 #include "error.h"
-
-extern int lineNo;
-extern int colNo;
-extern int currentChar;
+#include "trace.h"
+#include "memtrack.h"
+#include "platform.h"
+#include "scanner.h"
 
 extern CharCode charCodes[];
 
-CharCode currentCharCode;
-int state = -1;
+THREAD_LOCAL CharCode currentCharCode;
+THREAD_LOCAL int state = -1;
+
+int scanOptions = SCAN_DEFAULT;
+
+TokenMask tokenFilter = ALL_TOKENS;
+int countTokens = 0;
+THREAD_LOCAL long long tokenCounts[TOKEN_TYPE_COUNT];
+THREAD_LOCAL long long commentCount, commentBytes;
+
+int maxIdentLen = MAX_IDENT_LEN;
+int maxNumLen = MAX_NUM_LEN;
+
+long long maxFileBytes = 0;
+long long maxFileTokens = 0;
+long long maxFileMillis = 0;
+
+THREAD_LOCAL CheckpointSink checkpointSink = NULL;
+THREAD_LOCAL long long nextCheckpoint = LLONG_MAX;
+
+THREAD_LOCAL jmp_buf budgetJump;
+THREAD_LOCAL long long budgetDeadline;
+
+THREAD_LOCAL TokenSink tokenSink = printToken;
 
 /***************************************************************/
 
 /// <summary>
-/// Helper function for reading next CharCode
+/// Count a lexed token and tell whether tokenFilter lets it through.
 /// </summary>
-void readCharCode()
+static int keepToken(TokenType tokenType)
 {
-    readChar();
-    if (currentChar >= 0)
-    {
-        currentCharCode = charCodes[currentChar];
-    }
-    else
-    {
-        currentCharCode = CHAR_UNKNOWN;
-    }
+    if (countTokens)
+        tokenCounts[tokenType]++;
+    return (tokenFilter & TOKEN_BIT(tokenType)) != 0;
 }
 
-void skipBlank()
+/// <summary>
+/// Total a comment running from startOffset up to endOffset.
+/// </summary>
+static void countComment(long long startOffset, long long endOffset)
 {
-    while (state == 1 && currentCharCode == CHAR_SPACE)
-    {
-        readCharCode();
-    }
-    state = 0;
+    commentCount++;
+    commentBytes += endOffset - startOffset;
 }
 
-void skipBlockComment()
-{
-    while (1)
-    {
-        switch (state)
-        {
-        case 3:
-            if (currentChar == EOF)
-            {
-                state = 40;
-            }
-            else if (currentCharCode == CHAR_TIMES)
-            {
-                readCharCode();
-                state = 4;
-            }
-            else
-            {
-                readCharCode();
-                state = 3;
-            }
-            break;
-
-        case 4:
-            if (currentChar == EOF)
-            {
-                state = 40;
-            }
-            else if (currentCharCode == CHAR_TIMES)
-            {
-                readCharCode();
-                state = 4;
-            }
-            else if (currentCharCode == CHAR_RPAR)
-            {
-                readCharCode();
-                state = 5;
-            }
-            else
-            {
-                state = 3;
-            }
-            break;
-
-        case 5:
-            state = 0;
-            return;
-
-        case 40:
-            error(ERR_ENDOFCOMMENT, lineNo, colNo);
-            return;
-
-        default:
-            break;
-        }
-    }
-}
+// Lexemes of char constants, which outlive the input they were read from.
+static const char printableChars[] = " !\"#$%&'()*+,-./0123456789:;<=>?@ABCDEFGHIJKLMNOPQRSTUVWXYZ[\\]^_`abcdefghijklmnopqrstuvwxyz{|}~";
+
+// Hand a symbol to the caller of getTokenInto, or lex on if it is filtered out.
+#define EMIT_TOKEN(tokenType, tokenLineNo, tokenColNo)         \
+    if (keepToken(tokenType))                                  \
+    {                                                          \
+        setToken(token, tokenType, tokenLineNo, tokenColNo);   \
+        return;                                                \
+    }                                                          \
+    continue
+
+// Positions, keywords in any case.
+#define LEX_NAME(name) name##Full
+#define LEX_POSITIONS 1
+#define LEX_FOLD_KEYWORDS 1
+#include "lexer.inc"
+#undef LEX_NAME
+#undef LEX_POSITIONS
+#undef LEX_FOLD_KEYWORDS
+
+// Positions, upper-case keywords only.
+#define LEX_NAME(name) name##Exact
+#define LEX_POSITIONS 1
+#define LEX_FOLD_KEYWORDS 0
+#include "lexer.inc"
+#undef LEX_NAME
+#undef LEX_POSITIONS
+#undef LEX_FOLD_KEYWORDS
+
+// No positions, keywords in any case.
+#define LEX_NAME(name) name##Unplaced
+#define LEX_POSITIONS 0
+#define LEX_FOLD_KEYWORDS 1
+#include "lexer.inc"
+#undef LEX_NAME
+#undef LEX_POSITIONS
+#undef LEX_FOLD_KEYWORDS
+
+// No positions, upper-case keywords only.
+#define LEX_NAME(name) name##Bare
+#define LEX_POSITIONS 0
+#define LEX_FOLD_KEYWORDS 0
+#include "lexer.inc"
+#undef LEX_NAME
+#undef LEX_POSITIONS
+#undef LEX_FOLD_KEYWORDS
 
-void skipLineComment()
+/// <summary>
+/// The entry points of one compiled lexer.
+/// </summary>
+typedef struct
 {
-    while (1)
-    {
-        if (currentChar == EOF || currentChar == '\n')
-        {
-            break;
-        }
+    void (*getTokenInto)(Token* token);
+    int (*lexTokens)(void);
+    void (*resumeLexer)(LexState lexState);
+} LexVariant;
 
-        readCharCode();
-    }
+// Indexed by the SCAN_POSITIONS and SCAN_FOLD_KEYWORDS bits of scanOptions.
+static const LexVariant lexVariants[SCAN_VARIANTS] = {
+    {getTokenIntoBare, lexTokensBare, resumeLexerBare},
+    {getTokenIntoExact, lexTokensExact, resumeLexerExact},
+    {getTokenIntoUnplaced, lexTokensUnplaced, resumeLexerUnplaced},
+    {getTokenIntoFull, lexTokensFull, resumeLexerFull},
+};
 
-    state = 0;
-}
+THREAD_LOCAL const LexVariant* lexVariant = &lexVariants[SCAN_DEFAULT];
 
-Token* readIdentKeyword(void)
+/// <summary>
+/// Prepare the lexer for a freshly opened input, picking the variant that
+/// scanOptions asks for.
+/// </summary>
+void initScanner(void)
 {
-    int startLineNo = lineNo;
-    int startColNo = colNo;
-
-    int identifierLength = 0;
-    char buf[MAX_IDENT_LEN + 1];
-
-    while (1)
+    lexVariant = &lexVariants[scanOptions & (SCAN_VARIANTS - 1)];
+    currentCharCode = currentChar == EOF ? CHAR_UNKNOWN : charCodes[currentChar];
+    state = 0;
+    if (countTokens)
     {
-        switch (state)
-        {
-        case 8:
-            // Accumulate letters and digits
-            if (currentCharCode == CHAR_LETTER || currentCharCode == CHAR_DIGIT)
-            {
-                // Check for length limit
-                if (identifierLength > MAX_IDENT_LEN)
-                {
-                    error(ERR_IDENTTOOLONG, lineNo, colNo);
-                    state = -1;
-                    return makeToken(TK_NONE, startLineNo, startColNo);
-                }
-
-                buf[identifierLength++] = currentChar;
-                readCharCode();
-                state = 8;
-            }
-            else
-            {
-                state = 9;
-            }
-            break;
-
-        case 9:
-            buf[identifierLength] = '\0';
-
-            TokenType keywordType = checkKeyword(buf);
-            TokenType tokenType = keywordType == TK_NONE ? TK_IDENT : keywordType;
-
-            Token* token = makeToken(tokenType, startLineNo, startColNo);
-            // Copy lexeme to token->string.
-#ifdef _MSC_VER
-            strncpy_s(token->string, sizeof(token->string), buf, identifierLength);
-#else
-            strncpy(token->string, buf, identifierLength);
-#endif
-            state = 0;
-            return token;
-        default:
-            break;
-        }
+        memset(tokenCounts, 0, sizeof(tokenCounts));
+        commentCount = commentBytes = 0;
     }
 }
 
-Token* readNumber(void)
+/// <summary>
+/// Lex the next token into *token, so a caller can reuse one slot.
+/// </summary>
+void getTokenInto(Token* token)
 {
-    int startLineNo = lineNo;
-    int startColNo = colNo;
-
-    int numberLength = 0;
-    char buf[MAX_NUM_LEN + 1];
-
-    while (1)
-    {
-        switch (state)
-        {
-        case 10:
-            // Accumulate digits
-            if (currentCharCode == CHAR_DIGIT)
-            {
-                if (numberLength > MAX_NUM_LEN)
-                {
-                    error(ERR_NUMLITERALTOOLONG, lineNo, colNo);
-                    state = -1;
-                    return makeToken(TK_NONE, startLineNo, startColNo);
-                }
-
-                buf[numberLength++] = currentChar;
-                readCharCode();
-                state = 10;
-            }
-            else
-            {
-                state = 11;
-            }
-            break;
-
-        case 11:
-            buf[numberLength] = '\0';
-
-            Token* numberToken = makeToken(TK_NUMBER, startLineNo, startColNo);
-
-            // Copy lexeme to token->string.
-#ifdef _MSC_VER
-            strncpy_s(numberToken->string, sizeof(numberToken->string), buf, numberLength);
-#else
-            strncpy(numberToken->string, buf, numberLength);
-#endif
-            numberToken->value = atoi(buf);
-
-            state = 0;
-            return numberToken;
-        default:
-            break;
-        }
-    }
+    lexVariant->getTokenInto(token);
 }
 
-Token* readConstChar(void)
+/// <summary>
+/// Prepare the lexer for input opened at a checkpoint, finishing the comment
+/// the checkpoint was taken in.
+/// </summary>
+void resumeScanner(LexState lexState)
 {
-    int startLineNo = lineNo;
-    int startColNo = colNo;
-    int charValue;
-
-    readCharCode();
-
-    // Check if currentChar is a printable character.
-    if (currentChar >= 0x20 && currentChar <= 0x7E)
-    {
-        charValue = currentChar;
-
-        readCharCode();
-        if (currentCharCode == CHAR_SINGLEQUOTE)
-        {
-            readCharCode();
-            Token* constCharToken = makeToken(TK_CHAR, startLineNo, startColNo);
-            constCharToken->value = charValue;
-            constCharToken->string[0] = charValue;
-            constCharToken->string[1] = '\0';
-
-            state = 0;
-            return constCharToken;
-        }
-    }
-
-    error(ERR_INVALIDCHARCONSTANT, lineNo, colNo);
-    state = -1;
-    return makeToken(TK_NONE, startLineNo, startColNo);
+    initScanner();
+    lexVariant->resumeLexer(lexState);
 }
 
 Token* getToken(void)
 {
-    Token* token;
-    int startLineNo, startColNo;
-
-    if (currentChar == EOF)
-        return makeToken(TK_EOF, lineNo, colNo);
-
-    // Upon entering getToken, state should be 0
-    if (state != 0)
-    {
-        error(ERR_INTERNALERROR, lineNo, colNo);
-    }
-
-    switch (charCodes[currentChar])
-    {
-    case CHAR_SPACE:
-        state = 1;
-        skipBlank();
-        return getToken();
-
-    case CHAR_LETTER:
-        state = 8;
-        return readIdentKeyword();
-
-    case CHAR_DIGIT:
-        state = 10;
-        return readNumber();
-
-    case CHAR_PLUS:
-        token = makeToken(SB_PLUS, lineNo, colNo);
-        readCharCode();
-        state = 0;
-        return token;
-
-    case CHAR_MINUS:
-        token = makeToken(SB_MINUS, lineNo, colNo);
-        readCharCode();
-        state = 0;
-        return token;
-
-    case CHAR_TIMES:
-        token = makeToken(SB_TIMES, lineNo, colNo);
-        readCharCode();
-        state = 0;
-        return token;
-
-    case CHAR_SLASH:
-        token = makeToken(SB_SLASH, lineNo, colNo);
-        readCharCode();
-        state = 0;
-        return token;
-
-    case CHAR_EQ:
-        token = makeToken(SB_EQ, lineNo, colNo);
-        readCharCode();
-        state = 0;
-        return token;
-
-    case CHAR_LPAR:
-        startLineNo = lineNo;
-        startColNo = colNo;
-
-        readCharCode();
-        if (currentCharCode == CHAR_PERIOD)
-        {
-            readCharCode();
-            state = 0;
-            return makeToken(SB_LSEL, startLineNo, startColNo);
-        }
-        else if (currentCharCode == CHAR_TIMES)
-        {
-            readCharCode();
-            state = 3;
-            skipBlockComment();
-            return getToken();
-        }
-        else
-        {
-            state = 0;
-            return makeToken(SB_LPAR, startLineNo, startColNo);
-        }
-
-    case CHAR_SINGLEQUOTE:
-        return readConstChar();
-
-    case CHAR_LT:
-        startLineNo = lineNo;
-        startColNo = colNo;
-
-        readCharCode();
-        if (currentCharCode == CHAR_EQ)
-        {
-            readCharCode();
-            state = 0;
-            return makeToken(SB_LE, startLineNo, startColNo);
-        }
-        else
-        {
-            state = 0;
-            return makeToken(SB_LT, startLineNo, startColNo);
-        }
-
-    case CHAR_GT:
-        startLineNo = lineNo;
-        startColNo = colNo;
-
-        readCharCode();
-        if (currentCharCode == CHAR_EQ)
-        {
-            readCharCode();
-            state = 0;
-            return makeToken(SB_GE, startLineNo, startColNo);
-        }
-        else
-        {
-            state = 0;
-            return makeToken(SB_GT, startLineNo, startColNo);
-        }
-
-    case CHAR_EXCLAIMATION:
-        startLineNo = lineNo;
-        startColNo = colNo;
-
-        readCharCode();
-        if (currentCharCode == CHAR_EQ)
-        {
-            readCharCode();
-            state = 0;
-            return makeToken(SB_NEQ, startLineNo, startColNo);
-        }
-        else
-        {
-            error(ERR_INVALIDSYMBOL, lineNo, colNo);
-            state = -1;
-            return makeToken(TK_NONE, startLineNo, startColNo);
-        }
-
-    case CHAR_PERIOD:
-        startLineNo = lineNo;
-        startColNo = colNo;
-
-        readCharCode();
-        if (currentCharCode == CHAR_RPAR)
-        {
-            readCharCode();
-            state = 0;
-            return makeToken(SB_RSEL, startLineNo, startColNo);
-        }
-        else
-        {
-            state = 0;
-            return makeToken(SB_PERIOD, startLineNo, startColNo);
-        }
-
-    case CHAR_COLON:
-        startLineNo = lineNo;
-        startColNo = colNo;
-
-        readCharCode();
-        if (currentCharCode == CHAR_EQ)
-        {
-            readCharCode();
-            state = 0;
-            return makeToken(SB_ASSIGN, startLineNo, startColNo);
-        }
-        else
-        {
-            state = 0;
-            return makeToken(SB_COLON, startLineNo, startColNo);
-        }
-
-    case CHAR_COMMA:
-        token = makeToken(SB_COMMA, lineNo, colNo);
-        readCharCode();
-        state = 0;
-        return token;
-
-    case CHAR_SEMICOLON:
-        token = makeToken(SB_SEMICOLON, lineNo, colNo);
-        readCharCode();
-        state = 0;
-        return token;
-
-    case CHAR_RPAR:
-        token = makeToken(SB_RPAR, lineNo, colNo);
-        readCharCode();
-        state = 0;
-        return token;
-
-    case CHAR_DOUBLEQUOTE:
-        readCharCode();
-        skipLineComment();
-        return getToken();
-
-    default:
-        token = makeToken(TK_NONE, lineNo, colNo);
-        error(ERR_INVALIDSYMBOL, lineNo, colNo);
-        readCharCode();
-        return token;
-    }
+    // A plain malloc block like makeToken's, so callers may free() it.
+    Token* token = (Token*)malloc(sizeof(Token));
+    if (token == NULL)
+        return NULL;
+    memAccount(MEM_TOKENS, sizeof(Token));
+    getTokenInto(token);
+    return token;
 }
 
 /******************************************************************/
 
 void printToken(Token* token)
 {
+    FILE* out = outputFile();
+    const char* name = tokenTypeName(token->tokenType);
 
-    printf("%d-%d:", token->lineNo, token->colNo);
-
+    // One call per token: each takes the stream lock.
     switch (token->tokenType)
     {
-    case TK_NONE:
-        printf("TK_NONE\n");
-        break;
     case TK_IDENT:
-        printf("TK_IDENT(%s)\n", token->string);
-        break;
     case TK_NUMBER:
-        printf("TK_NUMBER(%s)\n", token->string);
+        fprintf(out, "%d-%d:%s(%.*s)\n", token->lineNo, token->colNo, name, token->length, token->lexeme);
         break;
     case TK_CHAR:
-        printf("TK_CHAR(\'%s\')\n", token->string);
+        fprintf(out, "%d-%d:%s(\'%.*s\')\n", token->lineNo, token->colNo, name, token->length, token->lexeme);
         break;
-    case TK_EOF:
-        printf("TK_EOF\n");
+    default:
+        fprintf(out, "%d-%d:%s\n", token->lineNo, token->colNo, name);
         break;
+    }
+}
 
-    case KW_PROGRAM:
-        printf("KW_PROGRAM\n");
-        break;
-    case KW_CONST:
-        printf("KW_CONST\n");
-        break;
-    case KW_TYPE:
-        printf("KW_TYPE\n");
-        break;
-    case KW_VAR:
-        printf("KW_VAR\n");
-        break;
-    case KW_INTEGER:
-        printf("KW_INTEGER\n");
-        break;
-    case KW_CHAR:
-        printf("KW_CHAR\n");
-        break;
-    case KW_ARRAY:
-        printf("KW_ARRAY\n");
-        break;
-    case KW_OF:
-        printf("KW_OF\n");
-        break;
-    case KW_FUNCTION:
-        printf("KW_FUNCTION\n");
-        break;
-    case KW_PROCEDURE:
-        printf("KW_PROCEDURE\n");
-        break;
-    case KW_BEGIN:
-        printf("KW_BEGIN\n");
-        break;
-    case KW_END:
-        printf("KW_END\n");
-        break;
-    case KW_CALL:
-        printf("KW_CALL\n");
-        break;
-    case KW_IF:
-        printf("KW_IF\n");
-        break;
-    case KW_THEN:
-        printf("KW_THEN\n");
-        break;
-    case KW_ELSE:
-        printf("KW_ELSE\n");
-        break;
-    case KW_WHILE:
-        printf("KW_WHILE\n");
-        break;
-    case KW_DO:
-        printf("KW_DO\n");
-        break;
-    case KW_FOR:
-        printf("KW_FOR\n");
-        break;
-    case KW_TO:
-        printf("KW_TO\n");
-        break;
+/// <summary>
+/// InputCheck enforcing the byte and time budgets, even inside long comments.
+/// </summary>
+void checkBudget(long long offset)
+{
+    if ((maxFileBytes > 0 && offset > maxFileBytes) ||
+        (maxFileMillis > 0 && traceNow() > budgetDeadline))
+        longjmp(budgetJump, 1);
+}
 
-    case SB_SEMICOLON:
-        printf("SB_SEMICOLON\n");
-        break;
-    case SB_COLON:
-        printf("SB_COLON\n");
-        break;
-    case SB_PERIOD:
-        printf("SB_PERIOD\n");
-        break;
-    case SB_COMMA:
-        printf("SB_COMMA\n");
-        break;
-    case SB_ASSIGN:
-        printf("SB_ASSIGN\n");
-        break;
-    case SB_EQ:
-        printf("SB_EQ\n");
-        break;
-    case SB_NEQ:
-        printf("SB_NEQ\n");
-        break;
-    case SB_LT:
-        printf("SB_LT\n");
-        break;
-    case SB_LE:
-        printf("SB_LE\n");
-        break;
-    case SB_GT:
-        printf("SB_GT\n");
-        break;
-    case SB_GE:
-        printf("SB_GE\n");
-        break;
-    case SB_PLUS:
-        printf("SB_PLUS\n");
-        break;
-    case SB_MINUS:
-        printf("SB_MINUS\n");
-        break;
-    case SB_TIMES:
-        printf("SB_TIMES\n");
-        break;
-    case SB_SLASH:
-        printf("SB_SLASH\n");
-        break;
-    case SB_LPAR:
-        printf("SB_LPAR\n");
-        break;
-    case SB_RPAR:
-        printf("SB_RPAR\n");
-        break;
-    case SB_LSEL:
-        printf("SB_LSEL\n");
-        break;
-    case SB_RSEL:
-        printf("SB_RSEL\n");
-        break;
+/// <summary>
+/// Lex every token of the opened input into tokenSink. Returns
+/// SCAN_BUDGET_EXCEEDED if a budget stopped the scan early.
+/// </summary>
+int scanTokens(char* fileName)
+{
+    int status;
+
+    memBeginFile(fileName);
+    initScanner();
+    budgetDeadline = traceNow() + maxFileMillis * 1000;
+
+    TRACE_BEGIN(lexStart);
+    if (setjmp(budgetJump) == 0)
+    {
+        if (maxFileBytes > 0 || maxFileMillis > 0)
+            setInputCheck(checkBudget);
+
+        status = lexVariant->lexTokens();
     }
+    else
+    {
+        status = SCAN_BUDGET_EXCEEDED;
+    }
+    setInputCheck(NULL);
+    TRACE_END(lexStart, "lex", fileName);
+
+    return status;
+}
+
+void flushOutput(char* fileName)
+{
+    TRACE_BEGIN(flushStart);
+    fflush(outputFile());
+    TRACE_END(flushStart, "flush", fileName);
 }
 
 int scan(char* fileName)
 {
-    Token* token;
+    int status;
+
+    TRACE_BEGIN(fileStart);
 
     if (openInputStream(fileName) == IO_ERROR)
         return IO_ERROR;
 
-    currentCharCode = charCodes[currentChar];
-    state = 0;
-
-    while (1)
-    {
-        token = getToken();
-        if (token->tokenType == TK_EOF)
-        {
-            free(token);
-            break;
-        }
-        else
-        {
-            printToken(token);
-            free(token);
-        }
-    }
+    status = scanTokens(fileName);
+    flushOutput(fileName);
 
+    if (ferror(inputStream))
+        status = IO_ERROR;
     closeInputStream();
-    return IO_SUCCESS;
-}
 
-/******************************************************************/
+    TRACE_END(fileStart, "file", fileName);
+    return status;
+}
 
-int main(int argc, char* argv[])
+int scanBuffer(char* fileName, const unsigned char* data, size_t len)
 {
-    if (argc <= 1)
-    {
-        printf("scanner: no input file.\n");
-        return -1;
-    }
+    int status;
 
-    if (scan(argv[1]) == IO_ERROR)
-    {
-        printf("Can\'t read input file!\n");
-        return -1;
-    }
+    TRACE_BEGIN(fileStart);
+
+    openInputBuffer(data, len);
+    status = scanTokens(fileName);
+    flushOutput(fileName);
 
-    return 0;
+    TRACE_END(fileStart, "file", fileName);
+    return status;
 }
@@ -0,0 +1,90 @@
+/*
+ * @copyright (c) 2026, agent
+ * @author agent
+ * @version 1.0
+ */
+
+#ifndef __SCANNER_H__
+#define __SCANNER_H__
+
+#include "token.h"
+#include "platform.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Returned by the scan functions, next to IO_ERROR and IO_SUCCESS, when a
+// file is cut short by one of its budgets.
+#define SCAN_BUDGET_EXCEEDED 2
+
+// Receives every token scanned by scan() and friends; printToken by default.
+typedef void (*TokenSink)(Token *token);
+extern THREAD_LOCAL TokenSink tokenSink;
+
+// Lexer features scanOptions can leave out. Every combination is a lexer of
+// its own, compiled without the dead work; initScanner picks one. Without
+// SCAN_POSITIONS tokens and errors report line and column 0, and without
+// SCAN_FOLD_KEYWORDS only upper-case keywords are recognized.
+#define SCAN_POSITIONS 0x1
+#define SCAN_FOLD_KEYWORDS 0x2
+#define SCAN_DEFAULT (SCAN_POSITIONS | SCAN_FOLD_KEYWORDS)
+#define SCAN_VARIANTS 4
+extern int scanOptions;
+
+// Token types the lexer hands on, one bit per TokenType. Tokens outside the
+// filter are lexed and counted but never built, so they cost no sink call.
+typedef unsigned long long TokenMask;
+#define TOKEN_BIT(tokenType) (1ULL << (tokenType))
+#define ALL_TOKENS (~0ULL)
+#define KEYWORD_TOKENS (TOKEN_BIT(KW_TO + 1) - TOKEN_BIT(KW_PROGRAM))
+#define SYMBOL_TOKENS (TOKEN_BIT(SB_RSEL + 1) - TOKEN_BIT(SB_SEMICOLON))
+extern TokenMask tokenFilter;
+
+// When set, tokenCounts totals every token lexed since initScanner, whether
+// or not it passes tokenFilter. A filter of 0 makes scanning count-only.
+extern int countTokens;
+extern THREAD_LOCAL long long tokenCounts[TOKEN_TYPE_COUNT];
+// Also counted with countTokens: comments and their bytes, delimiters included.
+extern THREAD_LOCAL long long commentCount, commentBytes;
+
+// Where the lexer stands between tokens when a checkpoint is taken.
+typedef enum
+{
+    LEX_CODE,
+    LEX_BLOCK_COMMENT,
+    LEX_LINE_COMMENT
+} LexState;
+
+// When set, called at the first point between tokens, or inside a comment,
+// at or past byte nextCheckpoint of the input; it should move nextCheckpoint on.
+typedef void (*CheckpointSink)(LexState lexState);
+extern THREAD_LOCAL CheckpointSink checkpointSink;
+extern THREAD_LOCAL long long nextCheckpoint;
+
+// Length limits checked by the lexer; MAX_IDENT_LEN and MAX_NUM_LEN by default.
+extern int maxIdentLen;
+extern int maxNumLen;
+
+// Per-file budgets; 0 means unlimited. Bytes and time are checked at least
+// every 64 KB of input, tokens after each token.
+extern long long maxFileBytes;
+extern long long maxFileTokens;
+extern long long maxFileMillis;
+
+void initScanner(void);
+void resumeScanner(LexState lexState);
+int scanTokens(char *fileName);
+// Returns a heap token the caller releases with freeToken (or free()).
+Token *getToken(void);
+void getTokenInto(Token *token);
+void printToken(Token *token);
+void flushOutput(char *fileName);
+int scan(char *fileName);
+int scanBuffer(char *fileName, const unsigned char *data, size_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
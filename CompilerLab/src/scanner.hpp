@@ -0,0 +1,257 @@
+/* C++20 interface to the scanner
+ * @copyright (c) 2026, agent
+ * @author agent
+ * @version 1.0
+ *
+ * Header only; link against libscanner.a.
+ *
+ *     for (Token& token : kpl::scan("example1.kpl"))
+ *         use(token.tokenType, kpl::text(token));
+ *
+ * scan and tokens take a file name; scanText and textTokens lex source
+ * text already in memory.
+ *
+ * Scanner state is per thread, so a thread scans one input at a time.
+ * Lexical errors go through errorHook and error() exactly as in C.
+ */
+
+#ifndef __SCANNER_HPP__
+#define __SCANNER_HPP__
+
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include "reader.h"
+#include "token.h"
+#include "scanner.h"
+
+namespace kpl
+{
+
+/// <summary>
+/// Owns the calling thread's scanner input: the constructor opens it, the
+/// destructor closes it.
+/// </summary>
+class Input
+{
+public:
+    explicit Input(const char *fileName) : stream(true)
+    {
+        if (openInputStream(const_cast<char *>(fileName)) == IO_ERROR)
+            throw std::runtime_error(std::string("Can't read input file ") + fileName);
+        initScanner();
+    }
+
+    // data must outlive the Input.
+    Input(const void *data, std::size_t len) : stream(false)
+    {
+        openInputBuffer(static_cast<const unsigned char *>(data), len);
+        initScanner();
+    }
+
+    Input(const Input &) = delete;
+    Input &operator=(const Input &) = delete;
+
+    ~Input()
+    {
+        if (stream)
+            closeInputStream();
+    }
+
+private:
+    bool stream;
+};
+
+/// <summary>
+/// The lexeme of an identifier, number or char token, viewed in the reader's
+/// buffers: valid until the next token is read.
+/// </summary>
+inline std::string_view text(const Token &token)
+{
+    return std::string_view(token.lexeme, token.length);
+}
+
+/// <summary>
+/// Input iterator over the tokens of the open input. Every position shares
+/// the range's single Token slot, so advancing invalidates the previous one.
+/// </summary>
+class TokenIterator
+{
+public:
+    using iterator_category = std::input_iterator_tag;
+    using value_type = Token;
+    using difference_type = std::ptrdiff_t;
+    using pointer = Token *;
+    using reference = Token &;
+
+    TokenIterator() = default;
+    explicit TokenIterator(Token *slot) : slot(slot) {}
+
+    Token &operator*() const { return *slot; }
+    Token *operator->() const { return slot; }
+
+    TokenIterator &operator++()
+    {
+        getTokenInto(slot);
+        return *this;
+    }
+
+    void operator++(int) { ++*this; }
+
+    bool operator==(std::default_sentinel_t) const { return slot->tokenType == TK_EOF; }
+
+private:
+    Token *slot = nullptr;
+};
+
+/// <summary>
+/// The tokens of one input, up to but not including TK_EOF. Not movable:
+/// iterators point at the slot inside the range.
+/// </summary>
+class TokenRange
+{
+public:
+    explicit TokenRange(const char *fileName) : input(fileName) {}
+    TokenRange(const void *data, std::size_t len) : input(data, len) {}
+
+    TokenRange(const TokenRange &) = delete;
+    TokenRange &operator=(const TokenRange &) = delete;
+
+    TokenIterator begin()
+    {
+        getTokenInto(&slot);
+        return TokenIterator(&slot);
+    }
+
+    std::default_sentinel_t end() const { return std::default_sentinel; }
+
+private:
+    Input input;
+    Token slot;
+};
+
+inline TokenRange scan(const char *fileName)
+{
+    return TokenRange(fileName);
+}
+
+// Scans source itself as text; it must outlive the range.
+inline TokenRange scanText(std::string_view source)
+{
+    return TokenRange(source.data(), source.size());
+}
+
+/***************************************************************/
+
+/// <summary>
+/// Minimal std::generator stand-in: a lazily resumed coroutine yielding
+/// references to T. The frame is allocated once per generator.
+/// </summary>
+template <typename T>
+class Generator
+{
+public:
+    struct promise_type
+    {
+        T *current = nullptr;
+        std::exception_ptr exception;
+
+        Generator get_return_object() { return Generator(Handle::from_promise(*this)); }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        std::suspend_always final_suspend() noexcept { return {}; }
+        std::suspend_always yield_value(T &value) noexcept
+        {
+            current = std::addressof(value);
+            return {};
+        }
+        void return_void() noexcept {}
+        void unhandled_exception() { exception = std::current_exception(); }
+    };
+
+    using Handle = std::coroutine_handle<promise_type>;
+
+    class iterator
+    {
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = T *;
+        using reference = T &;
+
+        iterator() = default;
+        explicit iterator(Handle handle) : handle(handle) {}
+
+        T &operator*() const { return *handle.promise().current; }
+        T *operator->() const { return handle.promise().current; }
+
+        iterator &operator++()
+        {
+            resume(handle);
+            return *this;
+        }
+
+        void operator++(int) { ++*this; }
+
+        bool operator==(std::default_sentinel_t) const { return handle.done(); }
+
+    private:
+        Handle handle;
+    };
+
+    explicit Generator(Handle handle) : handle(handle) {}
+    Generator(Generator &&other) noexcept : handle(std::exchange(other.handle, nullptr)) {}
+    Generator(const Generator &) = delete;
+    Generator &operator=(const Generator &) = delete;
+
+    ~Generator()
+    {
+        if (handle)
+            handle.destroy();
+    }
+
+    iterator begin()
+    {
+        resume(handle);
+        return iterator(handle);
+    }
+
+    std::default_sentinel_t end() const { return std::default_sentinel; }
+
+private:
+    static void resume(Handle handle)
+    {
+        handle.resume();
+        if (handle.done() && handle.promise().exception)
+            std::rethrow_exception(handle.promise().exception);
+    }
+
+    Handle handle;
+};
+
+/// <summary>
+/// Coroutine form of scan(): the file is opened at the first resume and
+/// closed when the generator finishes or is destroyed.
+/// </summary>
+inline Generator<Token> tokens(const char *fileName)
+{
+    for (Token &token : TokenRange(fileName))
+        co_yield token;
+}
+
+inline Generator<Token> textTokens(std::string_view source)
+{
+    for (Token &token : TokenRange(source.data(), source.size()))
+        co_yield token;
+}
+
+}
+
+#endif
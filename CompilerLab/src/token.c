@@ -5,12 +5,14 @@
  */
 
 #include <stdlib.h>
+#include <string.h>
 #include <ctype.h>
 #include "token.h"
+#include "memtrack.h"
 
 struct
 {
-    char string[MAX_IDENT_LEN + 1];
+    char string[MAX_KEYWORD_LEN + 1];
     TokenType tokenType;
 } keywords[KEYWORDS_COUNT] = {
     {"PROGRAM", KW_PROGRAM},
@@ -34,32 +36,104 @@ struct
     {"FOR", KW_FOR},
     {"TO", KW_TO}};
 
-int keywordEq(char *kw, char *string)
+const char *tokenTypeNames[TOKEN_TYPE_COUNT] = {
+    "TK_NONE", "TK_IDENT", "TK_NUMBER", "TK_CHAR", "TK_EOF",
+    "KW_PROGRAM", "KW_CONST", "KW_TYPE", "KW_VAR", "KW_INTEGER",
+    "KW_CHAR", "KW_ARRAY", "KW_OF", "KW_FUNCTION", "KW_PROCEDURE",
+    "KW_BEGIN", "KW_END", "KW_CALL", "KW_IF", "KW_THEN",
+    "KW_ELSE", "KW_WHILE", "KW_DO", "KW_FOR", "KW_TO",
+    "SB_SEMICOLON", "SB_COLON", "SB_PERIOD", "SB_COMMA", "SB_ASSIGN",
+    "SB_EQ", "SB_NEQ", "SB_LT", "SB_LE", "SB_GT",
+    "SB_GE", "SB_PLUS", "SB_MINUS", "SB_TIMES", "SB_SLASH",
+    "SB_LPAR", "SB_RPAR", "SB_LSEL", "SB_RSEL"};
+
+int keywordEq(char *kw, const char *string, int length)
 {
-    while ((*kw != '\0') && (*string != '\0'))
+    while ((*kw != '\0') && (length > 0))
     {
         if (*kw != toupper(*string))
             break;
         kw++;
         string++;
+        length--;
     }
-    return ((*kw == '\0') && (*string == '\0'));
+    return ((*kw == '\0') && (length == 0));
+}
+
+TokenType checkKeyword(const char *string, int length)
+{
+    int i;
+    if (length > MAX_KEYWORD_LEN)
+        return TK_NONE;
+    for (i = 0; i < KEYWORDS_COUNT; i++)
+        if (keywordEq(keywords[i].string, string, length))
+            return keywords[i].tokenType;
+    return TK_NONE;
 }
 
-TokenType checkKeyword(char *string)
+TokenType checkKeywordExact(const char *string, int length)
 {
     int i;
+    if (length > MAX_KEYWORD_LEN)
+        return TK_NONE;
     for (i = 0; i < KEYWORDS_COUNT; i++)
-        if (keywordEq(keywords[i].string, string))
+        if (keywords[i].string[0] == string[0] && strncmp(keywords[i].string, string, length) == 0 &&
+            keywords[i].string[length] == '\0')
             return keywords[i].tokenType;
     return TK_NONE;
 }
 
 Token *makeToken(TokenType tokenType, int lineNo, int colNo)
 {
+    // A plain malloc block, so callers may still release it with free().
     Token *token = (Token *)malloc(sizeof(Token));
+    if (token == NULL)
+        return NULL;
+    memAccount(MEM_TOKENS, sizeof(Token));
+    setToken(token, tokenType, lineNo, colNo);
+    return token;
+}
+
+void freeToken(Token *token)
+{
+    if (token == NULL)
+        return;
+    memAccount(MEM_TOKENS, -(long long)sizeof(Token));
+    free(token);
+}
+
+void setToken(Token *token, TokenType tokenType, int lineNo, int colNo)
+{
     token->tokenType = tokenType;
     token->lineNo = lineNo;
     token->colNo = colNo;
-    return token;
+    token->value = 0;
+    token->offset = 0;
+    token->length = 0;
+    token->flags = 0;
+    token->lexeme = NULL;
+}
+
+/// <summary>
+/// Copy the token's lexeme out of the reader as a NUL-terminated string,
+/// truncated to fit size. Returns the number of characters copied.
+/// </summary>
+size_t tokenText(Token *token, char *buf, size_t size)
+{
+    size_t len = (size_t)token->length;
+
+    if (size == 0)
+        return 0;
+    if (len >= size)
+        len = size - 1;
+
+    if (len > 0)
+        memcpy(buf, token->lexeme, len);
+    buf[len] = '\0';
+    return len;
+}
+
+const char *tokenTypeName(TokenType tokenType)
+{
+    return tokenTypeNames[tokenType];
 }
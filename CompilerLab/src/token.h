@@ -7,8 +7,10 @@
 #ifndef __TOKEN_H__
 #define __TOKEN_H__
 
+// Default length limits, see maxIdentLen and maxNumLen.
 #define MAX_IDENT_LEN 15
 #define MAX_NUM_LEN 10
+#define MAX_KEYWORD_LEN 9
 #define KEYWORDS_COUNT 20
 
 typedef enum
@@ -61,15 +63,47 @@ typedef enum
     SB_RSEL
 } TokenType;
 
+#define TOKEN_TYPE_COUNT (SB_RSEL + 1)
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Token flags: a TK_NUMBER too large for an int, whose value is INT_MAX.
+#define TOKEN_VALUE_SATURATED 0x1
+
+/// <summary>
+/// lexeme/length is the text of identifiers, numbers and chars, found at
+/// offset in the input. It points into the reader's buffers and is only
+/// valid until the next token is read; copy it to keep it.
+/// </summary>
 typedef struct
 {
-    char string[MAX_IDENT_LEN + 1];
     int lineNo, colNo;
     TokenType tokenType;
     int value;
+    long long offset;
+    int length;
+    int flags;
+    const char *lexeme;
 } Token;
 
-TokenType checkKeyword(char *string);
+TokenType checkKeyword(const char *string, int length);
+// checkKeyword for upper-case keywords only, without case folding.
+TokenType checkKeywordExact(const char *string, int length);
+// Heap tokens from makeToken and getToken are released with freeToken, which
+// keeps -memstats exact; free() remains valid but leaves them counted as live.
 Token *makeToken(TokenType tokenType, int lineNo, int colNo);
+void freeToken(Token *token);
+void setToken(Token *token, TokenType tokenType, int lineNo, int colNo);
+size_t tokenText(Token *token, char *buf, size_t size);
+// The TokenType as printed by printToken, e.g. "KW_PROGRAM".
+const char *tokenTypeName(TokenType tokenType);
+
+#ifdef __cplusplus
+}
+#endif
 
 #endif
@@ -0,0 +1,74 @@
+/* Example token ring consumer
+ * @copyright (c) 2026, agent
+ * @author agent
+ * @version 1.0
+ */
+
+#include <stdio.h>
+#include "tokenring.h"
+
+#define OPEN_TIMEOUT_MS 5000
+
+int main(int argc, char* argv[])
+{
+    TokenRing* ring;
+    const TokenRecord* records;
+    size_t count, i;
+    int done = 0;
+
+    if (argc <= 1)
+    {
+        printf("tokencat: no ring name.\n");
+        return -1;
+    }
+
+    ring = tokenRingOpen(argv[1], OPEN_TIMEOUT_MS);
+    if (ring == NULL)
+    {
+        printf("Can\'t open shared memory ring!\n");
+        return -1;
+    }
+
+    while (!done)
+    {
+        count = tokenRingAcquire(ring, &records);
+        if (count == 0)
+        {
+            printf("Token ring producer is gone!\n");
+            tokenRingClose(ring);
+            return -1;
+        }
+        for (i = 0; i < count && !done; i++)
+        {
+            const TokenRecord* record = &records[i];
+            switch (record->kind)
+            {
+            case RECORD_TOKEN:
+                if (record->length >= TOKEN_RING_STRING_SIZE)
+                    printf("%d-%d:%d(%s...) %d bytes\n", record->lineNo, record->colNo, record->tokenType,
+                           record->string, record->length);
+                else if (record->string[0] != '\0')
+                    printf("%d-%d:%d(%s)\n", record->lineNo, record->colNo, record->tokenType, record->string);
+                else
+                    printf("%d-%d:%d\n", record->lineNo, record->colNo, record->tokenType);
+                break;
+            case RECORD_FILE:
+                printf("file %d\n", record->value);
+                break;
+            case RECORD_ERROR:
+                printf("%d-%d:error %d\n", record->lineNo, record->colNo, record->value);
+                break;
+            case RECORD_IOERROR:
+                printf("file %d: read error\n", record->value);
+                break;
+            case RECORD_END:
+                done = 1;
+                break;
+            }
+        }
+        tokenRingRelease(ring, i);
+    }
+
+    tokenRingClose(ring);
+    return 0;
+}
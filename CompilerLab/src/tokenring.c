@@ -0,0 +1,334 @@
+/*
+ * @copyright (c) 2026, agent
+ * @author agent
+ * @version 1.0
+ */
+
+#include <stdlib.h>
+#include "tokenring.h"
+
+#ifndef __linux__
+
+TokenRing *tokenRingCreate(const char *name)
+{
+    (void)name;
+    return NULL;
+}
+
+TokenRecord *tokenRingReserve(TokenRing *ring)
+{
+    (void)ring;
+    return NULL;
+}
+
+void tokenRingCommit(TokenRing *ring)
+{
+    (void)ring;
+}
+
+TokenRing *tokenRingOpen(const char *name, int timeoutMs)
+{
+    (void)name;
+    (void)timeoutMs;
+    return NULL;
+}
+
+size_t tokenRingAcquire(TokenRing *ring, const TokenRecord **records)
+{
+    (void)ring;
+    (void)records;
+    return 0;
+}
+
+void tokenRingRelease(TokenRing *ring, size_t count)
+{
+    (void)ring;
+    (void)count;
+}
+
+void tokenRingClose(TokenRing *ring)
+{
+    (void)ring;
+}
+
+#else
+
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <stdatomic.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+#define SPIN_LIMIT 128
+#define WAIT_SLICE_MS 100
+
+/// <summary>
+/// Layout of the shared-memory object. head and tail count records ever
+/// consumed/produced and double as futex words. The pids let a waiting side
+/// notice that its peer is gone: 0 until the consumer attaches, -1 once a
+/// side has closed the ring.
+/// </summary>
+typedef struct
+{
+    atomic_uint magic;
+    uint32_t version;
+    uint32_t capacity;
+    uint32_t recordSize;
+    atomic_int producerPid;
+    atomic_int consumerPid;
+    _Alignas(64) atomic_uint head;
+    atomic_uint producerWaiting;
+    _Alignas(64) atomic_uint tail;
+    atomic_uint consumerWaiting;
+    _Alignas(64) TokenRecord records[];
+} SharedRing;
+
+struct TokenRing
+{
+    SharedRing *shared;
+    size_t mapSize;
+    unsigned mask;
+    int producer;
+    int peerGone;
+    char name[256];
+};
+
+static size_t ringSize(void)
+{
+    return sizeof(SharedRing) + TOKEN_RING_CAPACITY * sizeof(TokenRecord);
+}
+
+static void futexWait(atomic_uint *word, unsigned expected, const struct timespec *timeout)
+{
+    syscall(SYS_futex, (uint32_t *)word, FUTEX_WAIT, expected, timeout, NULL, 0);
+}
+
+static void futexWake(atomic_uint *word)
+{
+    syscall(SYS_futex, (uint32_t *)word, FUTEX_WAKE, 1, NULL, NULL, 0);
+}
+
+/// <summary>
+/// Whether the process in *peer can still move the ring, given how long we
+/// have waited for it so far.
+/// </summary>
+static int peerAlive(atomic_int *peer, int waitedMs)
+{
+    int pid = atomic_load(peer);
+
+    if (pid == 0)
+        return waitedMs < TOKEN_RING_ATTACH_TIMEOUT_MS;
+    if (pid < 0)
+        return 0;
+    return kill(pid, 0) == 0 || errno == EPERM;
+}
+
+/// <summary>
+/// Block until *word differs from value. The waiting flag is raised before
+/// re-checking so that the other side's store-then-check cannot miss us.
+/// Sleeps in slices of WAIT_SLICE_MS and returns 0 once the peer is gone.
+/// </summary>
+static int waitWhileEqual(atomic_uint *word, atomic_uint *waiting, unsigned value, atomic_int *peer)
+{
+    struct timespec slice = {0, WAIT_SLICE_MS * 1000000L};
+    int spins = 0, waitedMs = 0;
+
+    while (atomic_load(word) == value)
+    {
+        if (++spins < SPIN_LIMIT)
+            continue;
+        if (!peerAlive(peer, waitedMs))
+            return 0;
+
+        atomic_store(waiting, 1);
+        if (atomic_load(word) == value)
+            futexWait(word, value, &slice);
+        atomic_store(waiting, 0);
+        waitedMs += WAIT_SLICE_MS;
+    }
+    return 1;
+}
+
+static TokenRing *mapRing(const char *name, int fd, int producer)
+{
+    TokenRing *ring = (TokenRing *)malloc(sizeof(TokenRing));
+    void *map;
+
+    if (ring == NULL)
+        return NULL;
+
+    map = mmap(NULL, ringSize(), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (map == MAP_FAILED)
+    {
+        free(ring);
+        return NULL;
+    }
+
+    ring->shared = (SharedRing *)map;
+    ring->mapSize = ringSize();
+    ring->mask = TOKEN_RING_CAPACITY - 1;
+    ring->producer = producer;
+    ring->peerGone = 0;
+    strncpy(ring->name, name, sizeof(ring->name) - 1);
+    ring->name[sizeof(ring->name) - 1] = '\0';
+    return ring;
+}
+
+/***************************************************************/
+
+TokenRing *tokenRingCreate(const char *name)
+{
+    TokenRing *ring;
+    SharedRing *shared;
+    int fd;
+
+    // A ring of that name may belong to another scanner, so never take it
+    // over; errno is EEXIST then.
+    fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0)
+        return NULL;
+
+    if (ftruncate(fd, (off_t)ringSize()) < 0)
+    {
+        close(fd);
+        shm_unlink(name);
+        return NULL;
+    }
+
+    ring = mapRing(name, fd, 1);
+    close(fd);
+    if (ring == NULL)
+    {
+        shm_unlink(name);
+        return NULL;
+    }
+
+    shared = ring->shared;
+    shared->version = TOKEN_RING_VERSION;
+    shared->capacity = TOKEN_RING_CAPACITY;
+    shared->recordSize = sizeof(TokenRecord);
+    atomic_init(&shared->head, 0);
+    atomic_init(&shared->tail, 0);
+    atomic_init(&shared->producerWaiting, 0);
+    atomic_init(&shared->consumerWaiting, 0);
+    atomic_init(&shared->producerPid, (int)getpid());
+    atomic_init(&shared->consumerPid, 0);
+    // Publishing the magic number marks the ring as ready for consumers.
+    atomic_store(&shared->magic, TOKEN_RING_MAGIC);
+    return ring;
+}
+
+TokenRecord *tokenRingReserve(TokenRing *ring)
+{
+    SharedRing *shared = ring->shared;
+    unsigned tail = atomic_load_explicit(&shared->tail, memory_order_relaxed);
+
+    if (ring->peerGone)
+        return NULL;
+    // Full ring: wait for the consumer to move head.
+    if (tail - atomic_load(&shared->head) == shared->capacity &&
+        !waitWhileEqual(&shared->head, &shared->producerWaiting, tail - shared->capacity, &shared->consumerPid))
+    {
+        ring->peerGone = 1;
+        return NULL;
+    }
+
+    return &shared->records[tail & ring->mask];
+}
+
+void tokenRingCommit(TokenRing *ring)
+{
+    SharedRing *shared = ring->shared;
+
+    atomic_fetch_add(&shared->tail, 1);
+    if (atomic_load(&shared->consumerWaiting))
+        futexWake(&shared->tail);
+}
+
+TokenRing *tokenRingOpen(const char *name, int timeoutMs)
+{
+    struct timespec pause = {0, 1000000};
+    struct stat st;
+    TokenRing *ring;
+    int fd;
+
+    for (; timeoutMs >= 0; timeoutMs--)
+    {
+        fd = shm_open(name, O_RDWR, 0600);
+        if (fd >= 0)
+        {
+            if (fstat(fd, &st) == 0 && (size_t)st.st_size >= ringSize())
+            {
+                ring = mapRing(name, fd, 0);
+                close(fd);
+                if (ring == NULL)
+                    return NULL;
+                if (atomic_load(&ring->shared->magic) == TOKEN_RING_MAGIC)
+                {
+                    if (ring->shared->version != TOKEN_RING_VERSION ||
+                        ring->shared->recordSize != sizeof(TokenRecord))
+                    {
+                        tokenRingClose(ring);
+                        return NULL;
+                    }
+                    atomic_store(&ring->shared->consumerPid, (int)getpid());
+                    return ring;
+                }
+                munmap(ring->shared, ring->mapSize);
+                free(ring);
+            }
+            else
+            {
+                close(fd);
+            }
+        }
+        nanosleep(&pause, NULL);
+    }
+    return NULL;
+}
+
+size_t tokenRingAcquire(TokenRing *ring, const TokenRecord **records)
+{
+    SharedRing *shared = ring->shared;
+    unsigned head = atomic_load_explicit(&shared->head, memory_order_relaxed);
+    unsigned available, contiguous;
+
+    if (!waitWhileEqual(&shared->tail, &shared->consumerWaiting, head, &shared->producerPid))
+        return 0;
+
+    available = atomic_load_explicit(&shared->tail, memory_order_acquire) - head;
+    contiguous = shared->capacity - (head & ring->mask);
+
+    *records = &shared->records[head & ring->mask];
+    return available < contiguous ? available : contiguous;
+}
+
+void tokenRingRelease(TokenRing *ring, size_t count)
+{
+    SharedRing *shared = ring->shared;
+
+    atomic_fetch_add(&shared->head, (unsigned)count);
+    if (atomic_load(&shared->producerWaiting))
+        futexWake(&shared->head);
+}
+
+void tokenRingClose(TokenRing *ring)
+{
+    if (ring == NULL)
+        return;
+
+    atomic_store(ring->producer ? &ring->shared->producerPid : &ring->shared->consumerPid, -1);
+    munmap(ring->shared, ring->mapSize);
+    // The consumer removes the ring, or the producer if no consumer will.
+    if (!ring->producer || ring->peerGone)
+        shm_unlink(ring->name);
+    free(ring);
+}
+
+#endif
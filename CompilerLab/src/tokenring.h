@@ -0,0 +1,72 @@
+/* 
+ * @copyright (c) 2026, agent
+ * @author agent
+ * @version 1.0
+ */
+
+#ifndef __TOKENRING_H__
+#define __TOKENRING_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define TOKEN_RING_MAGIC 0x4B504C52
+#define TOKEN_RING_VERSION 3
+#define TOKEN_RING_CAPACITY 4096
+#define TOKEN_RING_STRING_SIZE 40
+// How long a producer with a full ring waits for a consumer to attach.
+#define TOKEN_RING_ATTACH_TIMEOUT_MS 5000
+
+typedef enum
+{
+    RECORD_TOKEN,   // tokenType, position, value, length and string are set
+    RECORD_FILE,    // a new input file starts; value is its index in the batch
+    RECORD_ERROR,   // value is the ErrorCode raised at lineNo-colNo
+    RECORD_IOERROR, // the file with index value could not be read
+    RECORD_END      // no more records will follow
+} RecordKind;
+
+/// <summary>
+/// Fixed-layout record shared between the scanner and consumer processes.
+/// string holds at most TOKEN_RING_STRING_SIZE - 1 bytes of the lexeme;
+/// length is the full lexeme length, so a longer one shows as truncated.
+/// </summary>
+typedef struct
+{
+    int32_t kind;
+    int32_t tokenType;
+    int32_t lineNo;
+    int32_t colNo;
+    int32_t value;
+    int32_t length;
+    char string[TOKEN_RING_STRING_SIZE];
+} TokenRecord;
+
+typedef struct TokenRing TokenRing;
+
+// Producer side, used by scanner -shm. Creating fails with errno EEXIST if
+// a ring of that name exists already. Reserving returns NULL once the
+// consumer has gone away, or never attached to a full ring.
+TokenRing *tokenRingCreate(const char *name);
+TokenRecord *tokenRingReserve(TokenRing *ring);
+void tokenRingCommit(TokenRing *ring);
+
+// Consumer side. Opening waits up to timeoutMs for the producer to create
+// the ring. Acquired records are read in place and stay valid until released.
+// Acquiring returns 0 only if the producer went away before RECORD_END.
+TokenRing *tokenRingOpen(const char *name, int timeoutMs);
+size_t tokenRingAcquire(TokenRing *ring, const TokenRecord **records);
+void tokenRingRelease(TokenRing *ring, size_t count);
+
+// Unmaps the ring; the consumer also removes the shared-memory object.
+void tokenRingClose(TokenRing *ring);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,219 @@
+/* 
+ * @copyright (c) 2026, agent
+ * @author agent
+ * @version 1.0
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+#include "platform.h"
+#include "trace.h"
+#include "memtrack.h"
+
+#define TRACE_CHUNK_SIZE 4096
+
+typedef struct
+{
+    const char *name;
+    const char *fileName;
+    long long startTime;
+    long long duration;
+} TraceEvent;
+
+/// <summary>
+/// Events of a single thread. Only the owning thread appends, the writer
+/// reads up to the published count, so no lock is needed.
+/// </summary>
+typedef struct TraceChunk
+{
+    TraceEvent events[TRACE_CHUNK_SIZE];
+    atomic_int count;
+    int threadId;
+    struct TraceChunk *next;
+} TraceChunk;
+
+int traceEnabled = 0;
+
+static char *traceFileName;
+static long long traceOrigin;
+static _Atomic(TraceChunk *) traceChunks = NULL;
+static atomic_int traceThreadCount = 0;
+
+static THREAD_LOCAL TraceChunk *threadChunk;
+static THREAD_LOCAL int threadId = -1;
+// The file name of the thread's last span and the copy events point to.
+static THREAD_LOCAL const char *lastFileName;
+static THREAD_LOCAL char *lastFileCopy;
+
+long long traceNow(void)
+{
+#ifdef _WIN32
+    static LARGE_INTEGER frequency;
+    LARGE_INTEGER counter;
+    if (frequency.QuadPart == 0)
+        QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+    return (long long)(counter.QuadPart * 1000000.0 / frequency.QuadPart);
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+#endif
+}
+
+static TraceChunk *newChunk(void)
+{
+    TraceChunk *chunk = (TraceChunk *)memAlloc(MEM_DIAGNOSTICS, sizeof(TraceChunk));
+    if (chunk == NULL)
+        return NULL;
+
+    if (threadId < 0)
+        threadId = atomic_fetch_add(&traceThreadCount, 1) + 1;
+
+    atomic_init(&chunk->count, 0);
+    chunk->threadId = threadId;
+
+    // Lock-free push onto the global chunk list.
+    chunk->next = atomic_load(&traceChunks);
+    while (!atomic_compare_exchange_weak(&traceChunks, &chunk->next, chunk))
+        ;
+    return chunk;
+}
+
+/// <summary>
+/// Return a copy of fileName that lives until the trace is written, as names
+/// may point into input that is gone by then, such as an unmapped archive.
+/// Consecutive spans of a file share one copy.
+/// </summary>
+static const char *keepFileName(const char *fileName)
+{
+    size_t size;
+    char *copy;
+
+    if (fileName == NULL)
+        return NULL;
+    if (fileName == lastFileName && strcmp(fileName, lastFileCopy) == 0)
+        return lastFileCopy;
+
+    size = strlen(fileName) + 1;
+    copy = (char *)memAlloc(MEM_DIAGNOSTICS, size);
+    if (copy == NULL)
+        return "?";
+    memcpy(copy, fileName, size);
+    lastFileName = fileName;
+    lastFileCopy = copy;
+    return copy;
+}
+
+void traceSpan(const char *name, const char *fileName, long long startTime)
+{
+    TraceEvent *event;
+    int count;
+
+    if (threadChunk == NULL || atomic_load_explicit(&threadChunk->count, memory_order_relaxed) == TRACE_CHUNK_SIZE)
+    {
+        threadChunk = newChunk();
+        if (threadChunk == NULL)
+            return;
+    }
+
+    count = atomic_load_explicit(&threadChunk->count, memory_order_relaxed);
+    event = &threadChunk->events[count];
+    event->name = name;
+    event->fileName = keepFileName(fileName);
+    event->startTime = startTime;
+    event->duration = traceNow() - startTime;
+    atomic_store_explicit(&threadChunk->count, count + 1, memory_order_release);
+}
+
+static void writeJsonString(FILE *f, const char *s)
+{
+    fputc('"', f);
+    for (; *s != '\0'; s++)
+    {
+        if (*s == '"' || *s == '\\')
+            fprintf(f, "\\%c", *s);
+        else if ((unsigned char)*s < 0x20)
+            fprintf(f, "\\u%04x", (unsigned char)*s);
+        else
+            fputc(*s, f);
+    }
+    fputc('"', f);
+}
+
+/// <summary>
+/// Dump every span recorded since traceStart as Chrome trace-event JSON, once.
+/// Registered with atexit so that runs ending in error() are traced too.
+/// </summary>
+static void traceWrite(void)
+{
+    TraceChunk *chunk;
+    int i, count, first = 1;
+    FILE *f;
+
+    if (!traceEnabled)
+        return;
+    traceEnabled = 0;
+
+#ifdef _MSC_VER
+    fopen_s(&f, traceFileName, "wt");
+#else
+    f = fopen(traceFileName, "wt");
+#endif
+    if (f == NULL)
+        return;
+
+    fprintf(f, "{\"traceEvents\":[\n");
+    for (chunk = atomic_load(&traceChunks); chunk != NULL; chunk = chunk->next)
+    {
+        count = atomic_load_explicit(&chunk->count, memory_order_acquire);
+        for (i = 0; i < count; i++)
+        {
+            TraceEvent *event = &chunk->events[i];
+
+            // Left over from an earlier trace in this process.
+            if (event->startTime < traceOrigin)
+                continue;
+            fprintf(f, "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%lld,\"dur\":%lld",
+                    first ? "" : ",\n", event->name, chunk->threadId,
+                    event->startTime - traceOrigin, event->duration);
+            if (event->fileName != NULL)
+            {
+                fprintf(f, ",\"args\":{\"file\":");
+                writeJsonString(f, event->fileName);
+                fputc('}', f);
+            }
+            fputc('}', f);
+            first = 0;
+        }
+    }
+    fprintf(f, "\n],\"displayTimeUnit\":\"ms\"}\n");
+    fclose(f);
+}
+
+int traceStart(char *fileName)
+{
+    static int registered = 0;
+
+    if (!registered && atexit(traceWrite) != 0)
+        return TRACE_ERROR;
+    registered = 1;
+
+    traceFileName = fileName;
+    traceOrigin = traceNow();
+    traceEnabled = 1;
+    return TRACE_SUCCESS;
+}
+
+void traceStop(void)
+{
+    traceWrite();
+}
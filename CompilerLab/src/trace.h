@@ -0,0 +1,40 @@
+/* 
+ * @copyright (c) 2026, agent
+ * @author agent
+ * @version 1.0
+ */
+
+#ifndef __TRACE_H__
+#define __TRACE_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define TRACE_ERROR 0
+#define TRACE_SUCCESS 1
+
+extern int traceEnabled;
+
+int traceStart(char *fileName);
+// Write the trace now instead of at exit, and stop recording.
+void traceStop(void);
+long long traceNow(void);
+// name must be a literal; fileName is copied, so it may be gone once the
+// span has been recorded.
+void traceSpan(const char *name, const char *fileName, long long startTime);
+
+// Spans cost a single branch while tracing is off.
+#define TRACE_BEGIN(var) long long var = traceEnabled ? traceNow() : 0
+#define TRACE_END(var, name, fileName)      \
+    do                                      \
+    {                                       \
+        if (traceEnabled)                   \
+            traceSpan(name, fileName, var); \
+    } while (0)
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,135 @@
+/* Heap token API test
+ * @copyright (c) 2026, agent
+ * @author agent
+ * @version 1.0
+ *
+ * Lexes a file three times: with getToken results released by free(), with
+ * them released by freeToken, and with getTokenInto. The three must agree
+ * token for token, and freeToken must leave MEM_TOKENS where it started.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "reader.h"
+#include "token.h"
+#include "memtrack.h"
+#include "scanner.h"
+
+#define MAX_TOKENS 100000
+
+typedef struct
+{
+    TokenType tokenType;
+    int lineNo, colNo, value;
+    char text[MAX_IDENT_LEN + MAX_NUM_LEN + 2];
+} SeenToken;
+
+SeenToken seen[3][MAX_TOKENS];
+int seenCount[3];
+
+enum
+{
+    RELEASE_FREE,
+    RELEASE_FREE_TOKEN,
+    SLOT
+};
+
+static const char *passNames[3] = {"getToken + free", "getToken + freeToken", "getTokenInto"};
+
+void record(int pass, Token *token)
+{
+    SeenToken *s;
+
+    if (seenCount[pass] == MAX_TOKENS)
+        return;
+    s = &seen[pass][seenCount[pass]++];
+    s->tokenType = token->tokenType;
+    s->lineNo = token->lineNo;
+    s->colNo = token->colNo;
+    s->value = token->value;
+    tokenText(token, s->text, sizeof(s->text));
+}
+
+/// <summary>
+/// Lex fileName once the way pass says. Returns 0 if it can't be read.
+/// </summary>
+int lexPass(char *fileName, int pass)
+{
+    Token slot;
+    Token *token;
+    TokenType tokenType;
+
+    if (openInputStream(fileName) == IO_ERROR)
+        return 0;
+    initScanner();
+    do
+    {
+        if (pass == SLOT)
+        {
+            getTokenInto(&slot);
+            record(pass, &slot);
+            tokenType = slot.tokenType;
+            continue;
+        }
+
+        token = getToken();
+        if (token == NULL)
+        {
+            closeInputStream();
+            return 0;
+        }
+        record(pass, token);
+        tokenType = token->tokenType;
+        if (pass == RELEASE_FREE)
+            free(token);
+        else
+            freeToken(token);
+    } while (tokenType != TK_EOF);
+    closeInputStream();
+    return 1;
+}
+
+int main(int argc, char *argv[])
+{
+    MemStats before, after;
+    int failed = 0, pass;
+
+    if (argc != 2)
+    {
+        printf("Usage: apitest FILE\n");
+        return -1;
+    }
+
+    for (pass = 0; pass < 3; pass++)
+    {
+        memProcessStats(&before);
+        if (!lexPass(argv[1], pass))
+        {
+            printf("Can\'t read %s\n", argv[1]);
+            return -1;
+        }
+        memProcessStats(&after);
+
+        if (pass == RELEASE_FREE_TOKEN &&
+            after.subsystems[MEM_TOKENS].current != before.subsystems[MEM_TOKENS].current)
+        {
+            printf("Test %s: Failed (%lld token bytes left)\n", passNames[pass],
+                   after.subsystems[MEM_TOKENS].current - before.subsystems[MEM_TOKENS].current);
+            failed++;
+            continue;
+        }
+        if (pass > 0 && (seenCount[pass] != seenCount[0] ||
+                         memcmp(seen[pass], seen[0], seenCount[0] * sizeof(SeenToken)) != 0))
+        {
+            printf("Test %s: Failed (tokens differ)\n", passNames[pass]);
+            failed++;
+            continue;
+        }
+        printf("Test %s: Pass (%d tokens)\n", passNames[pass], seenCount[pass]);
+    }
+
+    freeInputBuffer();
+    return failed > 0 ? 1 : 0;
+}
@@ -0,0 +1,607 @@
+/* In-process golden test runner
+ * @copyright (c) 2026, agent
+ * @author agent
+ * @version 1.0
+ *
+ * Runs the cases of a test file (name:input:expected per line, paths relative
+ * to the test file) against libscanner on worker threads, without spawning a
+ * process per case. Output is compared line by line after trimming, like
+ * test.py does, with the number of each "N us" timing ignored.
+ *
+ * A case may add a fourth field, name:input:expected:arguments, to test the
+ * scanner's command line instead. Each ';'-separated command is run through
+ * scannerMain in the test file's directory, and the outputs of all commands
+ * are compared together. {input} stands for the input and {tmp} for a
+ * scratch file removed before and after the case; if no command names
+ * {input}, the input is appended to each. Command lines set process-wide
+ * options, so these cases run one at a time once the others are done.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <setjmp.h>
+#include <threads.h>
+#include <stdatomic.h>
+
+#include "reader.h"
+#include "error.h"
+#include "trace.h"
+#include "scanner.h"
+#include "pipeline.h"
+#include "driver.h"
+
+#ifdef _MSC_VER
+#include <windows.h>
+#include <direct.h>
+#define chdir _chdir
+#else
+#include <unistd.h>
+#endif
+
+#define MAX_PATH_LEN 1024
+#define MAX_COMMAND_LEN 4096
+#define MAX_ARGUMENTS 256
+#define MAX_WORKERS 64
+
+typedef struct
+{
+    char name[256];
+    char input[MAX_PATH_LEN];
+    char expected[MAX_PATH_LEN];
+    char dir[MAX_PATH_LEN];
+    char inputName[MAX_PATH_LEN];
+    char arguments[MAX_COMMAND_LEN];
+    int passed;
+    long long micros;
+    char *output;
+    size_t outputLen;
+} TestCase;
+
+TestCase *tests;
+int testCount;
+int testCapacity;
+atomic_int nextTest;
+
+int repeat = 1;
+int detailed = 0;
+int pipelined = 0;
+
+THREAD_LOCAL jmp_buf abortJump;
+
+/******************************************************************/
+
+char *trim(char *s)
+{
+    char *end;
+
+    while (isspace((unsigned char)*s))
+        s++;
+    end = s + strlen(s);
+    while (end > s && isspace((unsigned char)end[-1]))
+        end--;
+    *end = '\0';
+    return s;
+}
+
+/// <summary>
+/// Read a whole file into a NUL-terminated buffer.
+/// </summary>
+char *readFile(FILE *f, size_t *len)
+{
+    char *data = NULL;
+    size_t capacity = 0, n;
+
+    *len = 0;
+    do
+    {
+        if (capacity - *len < 4096)
+        {
+            capacity += capacity / 2 + 4096;
+            data = (char *)realloc(data, capacity + 1);
+            if (data == NULL)
+                return NULL;
+        }
+        n = fread(data + *len, 1, capacity - *len, f);
+        *len += n;
+    } while (n > 0);
+    data[*len] = '\0';
+    return data;
+}
+
+/// <summary>
+/// Return the next line of *text, trimmed, or NULL at the end.
+/// </summary>
+char *nextLine(char **text)
+{
+    char *line = *text, *end;
+
+    if (*line == '\0')
+        return NULL;
+    end = strchr(line, '\n');
+    if (end != NULL)
+    {
+        *end = '\0';
+        *text = end + 1;
+    }
+    else
+    {
+        *text = line + strlen(line);
+    }
+    return trim(line);
+}
+
+int loadTests(char *testFile, char *testName)
+{
+    char dir[MAX_PATH_LEN];
+    char *slash;
+    char *text, *cursor, *line, *input, *expected, *arguments;
+    size_t len;
+    FILE *f;
+
+    // Command lines run in the test file's directory, so make it absolute.
+#ifdef _MSC_VER
+    if (_fullpath(dir, testFile, sizeof(dir)) == NULL)
+        return 0;
+    for (slash = dir; *slash != '\0'; slash++)
+        if (*slash == '\\')
+            *slash = '/';
+#else
+    if (strlen(testFile) >= sizeof(dir) || realpath(testFile, dir) == NULL)
+        return 0;
+#endif
+    slash = strrchr(dir, '/');
+    if (slash != NULL)
+        slash[1] = '\0';
+
+    f = fopen(testFile, "rt");
+    if (f == NULL)
+        return 0;
+    text = readFile(f, &len);
+    fclose(f);
+    if (text == NULL)
+        return 0;
+
+    cursor = text;
+    while ((line = nextLine(&cursor)) != NULL)
+    {
+        input = strchr(line, ':');
+        expected = input != NULL ? strchr(input + 1, ':') : NULL;
+        if (expected == NULL)
+            continue;
+        *input++ = '\0';
+        *expected++ = '\0';
+        // Arguments take the rest of the line, as they may hold ':' too.
+        arguments = strchr(expected, ':');
+        if (arguments != NULL)
+            *arguments++ = '\0';
+        if (testName != NULL && strcmp(line, testName) != 0)
+            continue;
+
+        if (testCount == testCapacity)
+        {
+            TestCase *grown = (TestCase *)realloc(tests, (testCapacity + testCapacity / 2 + 64) * sizeof(TestCase));
+            if (grown == NULL)
+            {
+                free(text);
+                return 0;
+            }
+            tests = grown;
+            testCapacity += testCapacity / 2 + 64;
+        }
+        memset(&tests[testCount], 0, sizeof(TestCase));
+        snprintf(tests[testCount].name, sizeof(tests[testCount].name), "%s", line);
+        snprintf(tests[testCount].input, MAX_PATH_LEN, "%s%s", input[0] == '/' ? "" : dir, input);
+        snprintf(tests[testCount].expected, MAX_PATH_LEN, "%s%s", expected[0] == '/' ? "" : dir, expected);
+        snprintf(tests[testCount].dir, MAX_PATH_LEN, "%s", dir);
+        snprintf(tests[testCount].inputName, MAX_PATH_LEN, "%s", trim(input));
+        snprintf(tests[testCount].arguments, MAX_COMMAND_LEN, "%s", arguments != NULL ? trim(arguments) : "");
+        testCount++;
+    }
+
+    free(text);
+    return 1;
+}
+
+/******************************************************************/
+
+/// <summary>
+/// errorHook while a case runs: print the error like the scanner does, then
+/// return to the runner instead of letting error() exit the process.
+/// </summary>
+void abortTest(ErrorCode err, int lineNo, int colNo)
+{
+    printError(err, lineNo, colNo);
+    fflush(outputFile());
+    longjmp(abortJump, 1);
+}
+
+/// <summary>
+/// Copy command to out with {input} and {tmp} replaced. Returns 0 if it
+/// doesn't fit.
+/// </summary>
+int expandCommand(const char *command, size_t length, TestCase *test, const char *tmpName, char *out,
+                  size_t size)
+{
+    const char *end = command + length;
+    size_t used = 0, n;
+
+    while (command < end)
+    {
+        const char *text = command;
+        n = 1;
+        if (strncmp(command, "{input}", 7) == 0)
+        {
+            text = test->inputName;
+            n = strlen(text);
+            command += 7;
+        }
+        else if (strncmp(command, "{tmp}", 5) == 0)
+        {
+            text = tmpName;
+            n = strlen(text);
+            command += 5;
+        }
+        else
+        {
+            command++;
+        }
+        if (used + n >= size)
+            return 0;
+        memcpy(out + used, text, n);
+        used += n;
+    }
+    out[used] = '\0';
+    return 1;
+}
+
+/// <summary>
+/// Split command into words at whitespace, in place, after argv[0]. Returns
+/// the number of entries in argv, or 0 if there are too many.
+/// </summary>
+int splitArguments(char *command, char *argv[], int size)
+{
+    int argc = 1;
+
+    argv[0] = "scanner";
+    while (1)
+    {
+        while (isspace((unsigned char)*command))
+            *command++ = '\0';
+        if (*command == '\0')
+            return argc;
+        if (argc == size - 1)
+            return 0;
+        argv[argc++] = command;
+        while (*command != '\0' && !isspace((unsigned char)*command))
+            command++;
+    }
+}
+
+/// <summary>
+/// Run the scanner commands of a case with arguments into out.
+/// </summary>
+int runCommands(TestCase *test, FILE *out)
+{
+    char tmpName[300], tmpPath[MAX_PATH_LEN + 300];
+    char expanded[MAX_COMMAND_LEN];
+    char *argv[MAX_ARGUMENTS];
+    const char *command = test->arguments, *end;
+    int appendInput = strstr(test->arguments, "{input}") == NULL;
+    int argc;
+    size_t i;
+
+    if (chdir(test->dir) != 0)
+        return 0;
+
+    // The scratch file is named after the case, so it shows up the same in
+    // the expected output of every run.
+    for (i = 0; test->name[i] != '\0' && i < sizeof(tmpName) - 5; i++)
+        tmpName[i] = isalnum((unsigned char)test->name[i]) ? test->name[i] : '_';
+    strcpy(tmpName + i, ".tmp");
+    snprintf(tmpPath, sizeof(tmpPath), "%s%s", test->dir, tmpName);
+    remove(tmpPath);
+
+    outputStream = out;
+    while (*command != '\0')
+    {
+        end = strchr(command, ';');
+        if (end == NULL)
+            end = command + strlen(command);
+        if (!expandCommand(command, (size_t)(end - command), test, tmpName, expanded, sizeof(expanded)))
+            break;
+        argc = splitArguments(expanded, argv, MAX_ARGUMENTS - 1);
+        if (argc == 0)
+            break;
+        if (appendInput)
+            argv[argc++] = test->inputName;
+        argv[argc] = NULL;
+
+        scannerMain(argc, argv);
+        fflush(out);
+
+        command = *end == ';' ? end + 1 : end;
+    }
+    outputStream = NULL;
+
+    remove(tmpPath);
+    return *command == '\0';
+}
+
+/// <summary>
+/// Scan the input of a case without arguments into out.
+/// </summary>
+void scanCase(TestCase *test, FILE *out)
+{
+    volatile int opened = 0;
+
+    outputStream = out;
+    errorHook = abortTest;
+
+    if (setjmp(abortJump) == 0)
+    {
+        if (pipelined)
+        {
+            scanPipelined(test->input);
+        }
+        else if (openInputStream(test->input) == IO_SUCCESS)
+        {
+            opened = 1;
+            scanTokens(test->input);
+            flushOutput(test->input);
+            closeInputStream();
+            opened = 0;
+        }
+    }
+    else if (opened)
+    {
+        closeInputStream();
+    }
+
+    errorHook = NULL;
+    outputStream = NULL;
+}
+
+/// <summary>
+/// Run one case into a temporary file and return what was printed.
+/// </summary>
+char *captureScan(TestCase *test, size_t *len)
+{
+    char *output = NULL;
+    int ran = 1;
+    FILE *out;
+
+    *len = 0;
+    out = tmpfile();
+    if (out == NULL)
+        return NULL;
+    if (test->arguments[0] != '\0')
+        ran = runCommands(test, out);
+    else
+        scanCase(test, out);
+
+    if (ran)
+    {
+        rewind(out);
+        output = readFile(out, len);
+    }
+    fclose(out);
+    return output;
+}
+
+/// <summary>
+/// Replace the number of each "N us" in line by '#', so that timings compare
+/// equal.
+/// </summary>
+void maskTimings(char *line)
+{
+    char *read = line, *write = line, *digits;
+
+    while (*read != '\0')
+    {
+        if (!isdigit((unsigned char)*read))
+        {
+            *write++ = *read++;
+            continue;
+        }
+        digits = read;
+        while (isdigit((unsigned char)*read))
+            read++;
+        if (strncmp(read, " us", 3) == 0 && !isalnum((unsigned char)read[3]))
+            *write++ = '#';
+        else
+            while (digits < read)
+                *write++ = *digits++;
+    }
+    *write = '\0';
+}
+
+int compareOutput(TestCase *test)
+{
+    char *expectedText, *got, *gotCursor, *wantCursor;
+    int equal = 1, lineIndex = 0;
+    size_t len;
+    FILE *f = fopen(test->expected, "rt");
+
+    if (f == NULL)
+        return 0;
+    expectedText = readFile(f, &len);
+    fclose(f);
+    if (expectedText == NULL)
+        return 0;
+
+    // Scan a copy: nextLine cuts the output into lines in place.
+    gotCursor = (char *)malloc(test->outputLen + 1);
+    if (gotCursor == NULL)
+    {
+        free(expectedText);
+        return 0;
+    }
+    memcpy(gotCursor, test->output, test->outputLen + 1);
+    got = gotCursor;
+    wantCursor = expectedText;
+
+    if (detailed)
+        printf("--- %s\n", test->name);
+    while (1)
+    {
+        char *g = nextLine(&gotCursor);
+        char *w = nextLine(&wantCursor);
+
+        if (g == NULL && w == NULL)
+            break;
+        if (g != NULL)
+            maskTimings(g);
+        if (w != NULL)
+            maskTimings(w);
+        if (g == NULL || w == NULL || strcmp(g, w) != 0)
+            equal = 0;
+        if (detailed)
+            printf("%4d %-30s %-30s %s\n", lineIndex, g ? g : "", w ? w : "",
+                   g != NULL && w != NULL && strcmp(g, w) == 0 ? "True" : "False");
+        lineIndex++;
+    }
+
+    free(got);
+    free(expectedText);
+    return equal;
+}
+
+/// <summary>
+/// Run a case repeat times, keeping the last output and the mean time.
+/// </summary>
+void runTest(TestCase *test)
+{
+    long long start = traceNow();
+    int i;
+
+    for (i = 0; i < repeat; i++)
+    {
+        free(test->output);
+        test->output = captureScan(test, &test->outputLen);
+    }
+    test->micros = (traceNow() - start) / repeat;
+}
+
+int worker(void *arg)
+{
+    int index;
+
+    (void)arg;
+    while ((index = atomic_fetch_add(&nextTest, 1)) < testCount)
+    {
+        // Cases with arguments are left for the main thread.
+        if (tests[index].arguments[0] == '\0')
+            runTest(&tests[index]);
+    }
+
+    freeInputBuffer();
+    return 0;
+}
+
+/// <summary>
+/// Number of hardware threads, the default for -j.
+/// </summary>
+int hardwareThreads(void)
+{
+#ifdef _MSC_VER
+    SYSTEM_INFO info;
+
+    GetSystemInfo(&info);
+    return (int)info.dwNumberOfProcessors;
+#else
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+
+    return count > 0 ? (int)count : 1;
+#endif
+}
+
+/******************************************************************/
+
+void printUsage(void)
+{
+    printf("Usage: testrunner [options] tests.txt\n");
+    printf("  -j N       run cases on N threads (default: one per hardware thread)\n");
+    printf("  -n NAME    run only the named case\n");
+    printf("  -r N       scan each case N times and report the mean time\n");
+    printf("  -d         show the output next to the expected output\n");
+    printf("  -pipeline  scan through the pipelined reader/lexer/writer\n");
+}
+
+int main(int argc, char *argv[])
+{
+    thrd_t threads[MAX_WORKERS];
+    char *testFile = NULL, *testName = NULL;
+    int threadCount = hardwareThreads(), failed = 0;
+    long long start, elapsed;
+    int i;
+
+    for (i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "-j") == 0 && i + 1 < argc)
+            threadCount = atoi(argv[++i]);
+        else if (strcmp(argv[i], "-n") == 0 && i + 1 < argc)
+            testName = argv[++i];
+        else if (strcmp(argv[i], "-r") == 0 && i + 1 < argc)
+            repeat = atoi(argv[++i]);
+        else if (strcmp(argv[i], "-d") == 0)
+            detailed = 1;
+        else if (strcmp(argv[i], "-pipeline") == 0)
+            pipelined = 1;
+        else if (argv[i][0] != '-' && testFile == NULL)
+            testFile = argv[i];
+        else
+        {
+            printUsage();
+            return -1;
+        }
+    }
+    if (testFile == NULL)
+    {
+        printUsage();
+        return -1;
+    }
+    if (threadCount < 1)
+        threadCount = 1;
+    if (threadCount > MAX_WORKERS)
+        threadCount = MAX_WORKERS;
+    if (repeat < 1)
+        repeat = 1;
+    // The pipeline's stages are shared by the whole process.
+    if (pipelined)
+        threadCount = 1;
+
+    if (!loadTests(testFile, testName))
+    {
+        printf("Can\'t read %s\n", testFile);
+        return -1;
+    }
+
+    initScanner();
+    start = traceNow();
+    for (i = 0; i < threadCount; i++)
+        if (thrd_create(&threads[i], worker, NULL) != thrd_success)
+            break;
+    threadCount = i;
+    for (i = 0; i < threadCount; i++)
+        thrd_join(threads[i], NULL);
+    for (i = 0; i < testCount; i++)
+        if (tests[i].arguments[0] != '\0')
+            runTest(&tests[i]);
+    freeInputBuffer();
+    elapsed = traceNow() - start;
+
+    for (i = 0; i < testCount; i++)
+    {
+        tests[i].passed = tests[i].output != NULL && compareOutput(&tests[i]);
+        if (!tests[i].passed)
+            failed++;
+        printf("Test %s: %s (%lld us)\n", tests[i].name, tests[i].passed ? "Pass" : "Failed", tests[i].micros);
+        free(tests[i].output);
+    }
+
+    printf("%d passed, %d failed, %d threads, %lld us\n", testCount - failed, failed, threadCount, elapsed);
+    free(tests);
+    return failed > 0 || testCount == 0 ? 1 : 0;
+}
@@ -43,14 +43,17 @@ def get_tests(test_file_path, test_name=None):
 
     with open(test_file_path) as f:
 
+        # Cases with a fourth field pass scanner arguments; only testrunner
+        # runs those.
         if test_name is None:
             for line in f.readlines():
-                test_case = line.strip().split(":")
-                test_cases.append(test_case)
+                test_case = line.strip().split(":", 3)
+                if len(test_case) == 3:
+                    test_cases.append(test_case)
         else:
             for line in f.readlines():
-                test_case = line.strip().split(":")
-                if test_case[0] == test_name:
+                test_case = line.strip().split(":", 3)
+                if len(test_case) == 3 and test_case[0] == test_name:
                     test_cases.append(test_case)
                     break
 